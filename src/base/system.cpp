@@ -40,6 +40,7 @@
 #include <netinet/in.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 
 #include <dirent.h>
@@ -341,6 +342,49 @@ char *io_read_all_str(IOHANDLE io)
 	return (char *)buffer;
 }
 
+int io_map(IOHANDLE io, void **result, unsigned *result_len)
+{
+	*result = nullptr;
+	*result_len = 0;
+
+	long signed_len = io_length(io);
+	if(signed_len <= 0)
+		return -1;
+
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno((FILE *)io));
+	if(file == INVALID_HANDLE_VALUE)
+		return -1;
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if(!mapping)
+		return -1;
+	void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	// the view keeps the mapping alive
+	CloseHandle(mapping);
+	if(!data)
+		return -1;
+#else
+	void *data = mmap(nullptr, signed_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno((FILE *)io), 0);
+	if(data == MAP_FAILED)
+		return -1;
+#endif
+
+	*result = data;
+	*result_len = (unsigned)signed_len;
+	return 0;
+}
+
+void io_unmap(void *data, unsigned len)
+{
+	if(!data)
+		return;
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, len);
+#endif
+}
+
 unsigned io_skip(IOHANDLE io, int size)
 {
 	fseek((FILE *)io, size, SEEK_CUR);
@@ -1943,6 +1987,15 @@ int net_tcp_listen(NETSOCKET sock, int backlog)
 	return err;
 }
 
+static void priv_net_set_nosigpipe(int sock)
+{
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+	// no send flag for it here, e.g. on macOS
+	int value = 1;
+	setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (const char *)&value, sizeof(value));
+#endif
+}
+
 int net_tcp_accept(NETSOCKET sock, NETSOCKET *new_sock, NETADDR *a)
 {
 	int s;
@@ -1959,6 +2012,7 @@ int net_tcp_accept(NETSOCKET sock, NETSOCKET *new_sock, NETADDR *a)
 
 		if(s != -1)
 		{
+			priv_net_set_nosigpipe(s);
 			sockaddr_to_netaddr((const struct sockaddr *)&addr, a);
 
 			*new_sock = (NETSOCKET_INTERNAL *)malloc(sizeof(**new_sock));
@@ -1978,6 +2032,7 @@ int net_tcp_accept(NETSOCKET sock, NETSOCKET *new_sock, NETADDR *a)
 
 		if(s != -1)
 		{
+			priv_net_set_nosigpipe(s);
 			*new_sock = (NETSOCKET_INTERNAL *)malloc(sizeof(**new_sock));
 			**new_sock = invalid_socket;
 			sockaddr_to_netaddr((const struct sockaddr *)&addr, a);
@@ -2023,11 +2078,17 @@ int net_tcp_connect_non_blocking(NETSOCKET sock, NETADDR bindaddr)
 int net_tcp_send(NETSOCKET sock, const void *data, int size)
 {
 	int bytes = -1;
+	// a peer that closed the connection fails the send instead of raising SIGPIPE
+#if defined(MSG_NOSIGNAL)
+	const int flags = MSG_NOSIGNAL;
+#else
+	const int flags = 0;
+#endif
 
 	if(sock->ipv4sock >= 0)
-		bytes = send((int)sock->ipv4sock, (const char *)data, size, 0);
+		bytes = send((int)sock->ipv4sock, (const char *)data, size, flags);
 	if(sock->ipv6sock >= 0)
-		bytes = send((int)sock->ipv6sock, (const char *)data, size, 0);
+		bytes = send((int)sock->ipv6sock, (const char *)data, size, flags);
 
 	return bytes;
 }
@@ -3745,6 +3806,28 @@ int str_utf8_check(const char *str)
 	return 1;
 }
 
+int str_valid_filename(const char *str)
+{
+	if(str[0] == '\0' || str_comp(str, ".") == 0 || str_comp(str, "..") == 0)
+		return 0;
+	if(str[0] == ' ' || str[str_length(str) - 1] == ' ' || str[str_length(str) - 1] == '.')
+		return 0;
+
+	const char *cursor = str;
+	int codepoint;
+	while((codepoint = str_utf8_decode(&cursor)))
+	{
+		if(codepoint == -1 || codepoint < 32 || codepoint == 127)
+			return 0;
+		switch(codepoint)
+		{
+		case '\\': case '/': case '|': case ':': case '*': case '?': case '<': case '>': case '"':
+			return 0;
+		}
+	}
+	return 1;
+}
+
 void str_utf8_stats(const char *str, size_t max_size, size_t max_count, size_t *size, size_t *count)
 {
 	const char *cursor = str;
@@ -282,6 +282,34 @@ void io_read_all(IOHANDLE io, void **result, unsigned *result_len);
  */
 char *io_read_all_str(IOHANDLE io);
 
+/**
+ * Maps the whole file into memory, copy-on-write.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file to map.
+ * @param result Receives the start of the mapped file.
+ * @param result_len Receives the file's length.
+ *
+ * @return 0 on success.
+ *
+ * @remark Writes to the mapping are private, they never reach the file.
+ * @remark The mapping stays valid after the file is closed.
+ * @remark Empty files can't be mapped.
+ * @remark The result must be released with @link io_unmap @endlink.
+ */
+int io_map(IOHANDLE io, void **result, unsigned *result_len);
+
+/**
+ * Releases a mapping created by @link io_map @endlink.
+ *
+ * @ingroup File-IO
+ *
+ * @param data Start of the mapped file.
+ * @param len Length of the mapped file.
+ */
+void io_unmap(void *data, unsigned len);
+
 /**
  * Skips data in a file.
  *
@@ -1082,6 +1110,8 @@ int net_tcp_connect(NETSOCKET sock, const NETADDR *addr);
  * @param size Size of the data to send.
  *
  * @return Number of bytes sent. Negative value on failure.
+ *
+ * @remark Sending to a peer that closed the connection fails, it doesn't raise SIGPIPE.
  */
 int net_tcp_send(NETSOCKET sock, const void *data, int size);
 
@@ -2387,6 +2417,20 @@ int str_utf8_encode(char *ptr, int chr);
 */
 int str_utf8_check(const char *str);
 
+/*
+	Function: str_valid_filename
+		Checks if a string is usable as the name of a file, not a path.
+
+	Parameters:
+		str - Pointer to a utf8 string.
+
+	Returns:
+		0 - empty, "." or "..", has a path separator, a character that
+			isn't allowed in file names or surrounding whitespace.
+		1 - the string is a valid file name.
+*/
+int str_valid_filename(const char *str);
+
 /*
 	Function: str_utf8_stats
 		Determines the byte size and utf8 character count of a utf8 string.
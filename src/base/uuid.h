@@ -1,6 +1,9 @@
 #ifndef BASE_UUID_H
 #define BASE_UUID_H
 
+#include <cstddef>
+#include <functional>
+
 enum
 {
 	UUID_MAXSTRSIZE = 37, // 12345678-0123-5678-0123-567890123456
@@ -30,4 +33,19 @@ void FormatUuid(CUuid Uuid, char *pBuffer, unsigned BufferLength);
 // Returns nonzero on failure.
 int ParseUuid(CUuid *pUuid, const char *pBuffer);
 
+namespace std {
+template<>
+struct hash<CUuid>
+{
+	// the bytes are random or a hash already, the first ones are enough
+	size_t operator()(const CUuid &Uuid) const
+	{
+		size_t Hash = 0;
+		for(unsigned i = 0; i < sizeof(size_t); i++)
+			Hash = (Hash << 8) | Uuid.m_aData[i];
+		return Hash;
+	}
+};
+}
+
 #endif // BASE_UUID_H
\ No newline at end of file
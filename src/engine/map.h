@@ -30,6 +30,9 @@ public:
 	virtual void Unload() = 0;
 	virtual SHA256_DIGEST Sha256() = 0;
 	virtual unsigned Crc() = 0;
+	// the map file as it is on disk, valid while the map is loaded
+	virtual const unsigned char *FileData() = 0;
+	virtual unsigned FileSize() = 0;
 };
 
 extern IEngineMap *CreateEngineMap();
@@ -232,6 +232,8 @@ public:
 
 	virtual void ChangeClientMap(int ClientID, CUuid *pMapID) = 0;
 	virtual int GetLoadedMapNum() const = 0;
+	// the Index-th loaded map, nullptr past the end
+	virtual class IMap *GetLoadedMap(int Index, const char **ppMapName, bool *pMenu) = 0;
 
 	virtual int GetOneWorldPlayerNum(int ClientID) const = 0;
 
@@ -242,6 +244,29 @@ public:
 
 	virtual const char *GetMainMap() = 0;
 	virtual const char *GetMenuMap() = 0;
+
+	// steps the tick watchdog takes under sustained overrun, a level includes all lower ones
+	enum
+	{
+		LOADSHED_NONE = 0,
+		LOADSHED_BOT_AI,
+		LOADSHED_IDLE_WORLDS,
+		LOADSHED_SNAPSHOTS,
+		LOADSHED_BOT_SPAWN,
+		NUM_LOADSHED_LEVELS
+	};
+	virtual int LoadShedLevel() const = 0;
+
+	// random generators that shape a session, their seeds go into the teehistorian
+	enum
+	{
+		SEED_MAP = 0,
+		SEED_BOT_AI,
+		SEED_WORLD,
+		NUM_SEEDS
+	};
+	// the recorded seed while replaying, otherwise Seed which gets recorded
+	virtual uint64_t SessionSeed(int Type, uint64_t Seed) = 0;
 };
 
 class IGameServer : public IInterface
@@ -261,6 +286,8 @@ public:
 	virtual void OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID) = 0;
 
 	virtual void OnClientConnected(int ClientID, const char *WorldName, bool Menu) = 0;
+	// moves an ingame client to another world using the map it already has loaded
+	virtual void OnClientTransfer(int ClientID, const char *WorldName, bool Menu) = 0;
 	virtual void OnClientEnter(int ClientID) = 0;
 	virtual void OnClientDrop(int ClientID, const char *pReason) = 0;
 	virtual void OnClientDirectInput(int ClientID, void *pInput) = 0;
@@ -278,6 +305,9 @@ public:
 	virtual void OnSetAuthed(int ClientID, int Level) = 0;
 	
 	virtual void OnUpdatePlayerServerInfo(char *aBuf, int BufSize, int ID) = 0;
+
+	// combined hash of all worlds after the last tick, see sv_world_checksum
+	virtual uint64_t WorldChecksum() const = 0;
 };
 
 extern IGameServer *CreateGameServer();
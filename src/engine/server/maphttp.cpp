@@ -0,0 +1,330 @@
+#include <base/math.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+#include "maphttp.h"
+
+// whether clients elsewhere could connect to the address
+static bool IsRoutable(const NETADDR &Addr)
+{
+	static const unsigned char s_aLoopback6[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+	static const unsigned char s_aUnspecified[16] = {0};
+	if(Addr.type == NETTYPE_IPV4)
+		return Addr.ip[0] != 127 && mem_comp(Addr.ip, s_aUnspecified, 4) != 0;
+	if(Addr.type == NETTYPE_IPV6)
+		return mem_comp(Addr.ip, s_aLoopback6, 16) != 0 && mem_comp(Addr.ip, s_aUnspecified, 16) != 0;
+	return false;
+}
+
+CMapHttpServer::CMapHttpServer() :
+	m_pConsole(nullptr),
+	m_pNetBan(nullptr),
+	m_Socket(nullptr),
+	m_Ready(false),
+	m_aBindUrl(),
+	m_BytesSent(0),
+	m_NumRequests(0)
+{
+	for(auto &Conn : m_aConnections)
+		Conn.m_State = CConnection::STATE_EMPTY;
+}
+
+void CMapHttpServer::Init(IConsole *pConsole, CNetBan *pNetBan)
+{
+	m_pConsole = pConsole;
+	m_pNetBan = pNetBan;
+	m_Ready = false;
+	m_aBindUrl[0] = '\0';
+
+	if(g_Config.m_SvMapHttpPort == 0)
+		return;
+
+	NETADDR BindAddr;
+	if(g_Config.m_SvMapHttpBindaddr[0] && net_host_lookup(g_Config.m_SvMapHttpBindaddr, &BindAddr, NETTYPE_ALL) == 0)
+	{
+		// got bindaddr, only listen on its address family
+		BindAddr.port = g_Config.m_SvMapHttpPort;
+	}
+	else
+	{
+		mem_zero(&BindAddr, sizeof(BindAddr));
+		BindAddr.type = NETTYPE_ALL;
+		BindAddr.port = g_Config.m_SvMapHttpPort;
+	}
+
+	m_Socket = net_tcp_create(BindAddr);
+	if(!m_Socket || net_tcp_listen(m_Socket, MAX_CONNECTIONS))
+	{
+		if(m_Socket)
+			net_tcp_close(m_Socket);
+		m_Socket = nullptr;
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "maphttp", "couldn't open socket. port might already be in use");
+		return;
+	}
+	net_set_non_blocking(m_Socket);
+
+	if(g_Config.m_SvMapHttpBindaddr[0] && IsRoutable(BindAddr))
+		net_addr_str(&BindAddr, m_aBindUrl, sizeof(m_aBindUrl), true);
+	else if(!g_Config.m_SvMapHttpUrl[0])
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "maphttp", "no public address, set sv_map_http_url or a concrete sv_map_http_bindaddr to advertise the downloads");
+
+	m_Ready = true;
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "bound to %s:%d", g_Config.m_SvMapHttpBindaddr, g_Config.m_SvMapHttpPort);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "maphttp", aBuf);
+}
+
+void CMapHttpServer::AddMap(const SHA256_DIGEST &Sha256, const unsigned char *pData, unsigned Size)
+{
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+
+	SMap Map;
+	Map.m_pData = pData;
+	Map.m_Size = Size;
+
+	std::lock_guard<std::mutex> Lock(m_MapsLock);
+	m_Maps[aSha256] = Map;
+}
+
+void CMapHttpServer::GetMapUrl(const char *pMapName, const SHA256_DIGEST &Sha256, char *pBuf, int BufSize) const
+{
+	if(!m_Ready)
+	{
+		pBuf[0] = '\0';
+		return;
+	}
+
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+
+	if(g_Config.m_SvMapHttpUrl[0])
+		str_format(pBuf, BufSize, "%s/%s_%s.map", g_Config.m_SvMapHttpUrl, pMapName, aSha256);
+	else if(m_aBindUrl[0])
+		str_format(pBuf, BufSize, "http://%s/%s_%s.map", m_aBindUrl, pMapName, aSha256);
+	else
+		pBuf[0] = '\0'; // clients couldn't reach a wildcard or loopback address
+}
+
+void CMapHttpServer::Accept()
+{
+	NETSOCKET Socket;
+	NETADDR Addr;
+	while(net_tcp_accept(m_Socket, &Socket, &Addr) > 0)
+	{
+		char aBuf[128];
+		if(m_pNetBan && m_pNetBan->IsBanned(&Addr, aBuf, sizeof(aBuf)))
+		{
+			net_tcp_close(Socket);
+			continue;
+		}
+
+		CConnection *pConn = nullptr;
+		for(auto &Conn : m_aConnections)
+		{
+			if(Conn.m_State == CConnection::STATE_EMPTY)
+			{
+				pConn = &Conn;
+				break;
+			}
+		}
+
+		if(!pConn)
+		{
+			// busy, the client falls back to the ingame download
+			static const char s_aBusy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+			net_tcp_send(Socket, s_aBusy, sizeof(s_aBusy) - 1);
+			net_tcp_close(Socket);
+			continue;
+		}
+
+		net_set_non_blocking(Socket);
+		pConn->m_State = CConnection::STATE_REQUEST;
+		pConn->m_Socket = Socket;
+		pConn->m_Addr = Addr;
+		pConn->m_LastActivity = time_get();
+		pConn->m_RequestSize = 0;
+	}
+}
+
+void CMapHttpServer::Respond(CConnection *pConn, int Status, const char *pStatus, const unsigned char *pBody, int BodySize, bool HeadOnly)
+{
+	pConn->m_HeaderSize = str_format(pConn->m_aHeader, sizeof(pConn->m_aHeader),
+		"HTTP/1.1 %d %s\r\nContent-Type: application/octet-stream\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+		Status, pStatus, BodySize);
+	pConn->m_pBody = HeadOnly ? nullptr : pBody;
+	pConn->m_BodySize = HeadOnly ? 0 : BodySize;
+	pConn->m_Sent = 0;
+	pConn->m_State = CConnection::STATE_RESPONSE;
+}
+
+void CMapHttpServer::HandleRequest(CConnection *pConn)
+{
+	m_NumRequests++;
+
+	// request line: <method> <target> HTTP/1.x
+	char *pMethod = pConn->m_aRequest;
+	char *pTarget = (char *)str_find(pMethod, " ");
+	if(!pTarget)
+	{
+		Respond(pConn, 400, "Bad Request", nullptr, 0, false);
+		return;
+	}
+	*pTarget++ = '\0';
+	char *pEnd = (char *)str_find(pTarget, " ");
+	if(!pEnd)
+	{
+		Respond(pConn, 400, "Bad Request", nullptr, 0, false);
+		return;
+	}
+	*pEnd = '\0';
+
+	bool HeadOnly = str_comp(pMethod, "HEAD") == 0;
+	if(!HeadOnly && str_comp(pMethod, "GET") != 0)
+	{
+		Respond(pConn, 405, "Method Not Allowed", nullptr, 0, false);
+		return;
+	}
+
+	char *pQuery = (char *)str_find(pTarget, "?");
+	if(pQuery)
+		*pQuery = '\0';
+
+	// the sha256 in front of the .map extension names the file
+	int Length = str_length(pTarget);
+	int HashStart = Length - 4 - (SHA256_MAXSTRSIZE - 1);
+	SHA256_DIGEST Sha256;
+	if(HashStart < 0 || str_comp(pTarget + Length - 4, ".map") != 0)
+	{
+		Respond(pConn, 404, "Not Found", nullptr, 0, HeadOnly);
+		return;
+	}
+	pTarget[Length - 4] = '\0';
+	if(sha256_from_str(&Sha256, pTarget + HashStart))
+	{
+		Respond(pConn, 404, "Not Found", nullptr, 0, HeadOnly);
+		return;
+	}
+
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+
+	SMap Map;
+	{
+		std::lock_guard<std::mutex> Lock(m_MapsLock);
+		auto It = m_Maps.find(aSha256);
+		if(It == m_Maps.end())
+		{
+			Respond(pConn, 404, "Not Found", nullptr, 0, HeadOnly);
+			return;
+		}
+		Map = It->second;
+	}
+
+	Respond(pConn, 200, "OK", Map.m_pData, Map.m_Size, HeadOnly);
+}
+
+void CMapHttpServer::Drop(CConnection *pConn)
+{
+	net_tcp_close(pConn->m_Socket);
+	pConn->m_Socket = nullptr;
+	pConn->m_State = CConnection::STATE_EMPTY;
+}
+
+void CMapHttpServer::Update()
+{
+	if(!m_Ready)
+		return;
+
+	Accept();
+
+	for(auto &Conn : m_aConnections)
+	{
+		CConnection *pConn = &Conn;
+		if(pConn->m_State == CConnection::STATE_EMPTY)
+			continue;
+
+		if(time_get() > pConn->m_LastActivity + TIMEOUT * time_freq())
+		{
+			Drop(pConn);
+			continue;
+		}
+
+		if(pConn->m_State == CConnection::STATE_REQUEST)
+		{
+			int Bytes = net_tcp_recv(pConn->m_Socket, pConn->m_aRequest + pConn->m_RequestSize, sizeof(pConn->m_aRequest) - 1 - pConn->m_RequestSize);
+			if(Bytes == 0 || (Bytes < 0 && !net_would_block()))
+			{
+				Drop(pConn);
+				continue;
+			}
+			if(Bytes > 0)
+			{
+				pConn->m_RequestSize += Bytes;
+				pConn->m_aRequest[pConn->m_RequestSize] = '\0';
+				pConn->m_LastActivity = time_get();
+
+				// the headers are of no interest, only wait for them to end
+				if(str_find(pConn->m_aRequest, "\r\n\r\n"))
+					HandleRequest(pConn);
+				else if(pConn->m_RequestSize >= (int)sizeof(pConn->m_aRequest) - 1)
+					Respond(pConn, 431, "Request Header Fields Too Large", nullptr, 0, false);
+			}
+		}
+
+		// send as much as the socket takes
+		while(pConn->m_State == CConnection::STATE_RESPONSE)
+		{
+			const unsigned char *pData;
+			int Size;
+			if(pConn->m_Sent < pConn->m_HeaderSize)
+			{
+				pData = (const unsigned char *)pConn->m_aHeader + pConn->m_Sent;
+				Size = pConn->m_HeaderSize - pConn->m_Sent;
+			}
+			else
+			{
+				int Offset = pConn->m_Sent - pConn->m_HeaderSize;
+				pData = pConn->m_pBody + Offset;
+				Size = pConn->m_BodySize - Offset;
+			}
+
+			if(Size == 0)
+			{
+				Drop(pConn);
+				break;
+			}
+
+			int Bytes = net_tcp_send(pConn->m_Socket, pData, Size);
+			if(Bytes < 0)
+			{
+				if(!net_would_block())
+					Drop(pConn);
+				break;
+			}
+
+			pConn->m_Sent += Bytes;
+			pConn->m_LastActivity = time_get();
+			if(pConn->m_Sent > pConn->m_HeaderSize)
+				m_BytesSent += minimum(Bytes, pConn->m_Sent - pConn->m_HeaderSize);
+		}
+	}
+}
+
+void CMapHttpServer::Shutdown()
+{
+	if(!m_Ready)
+		return;
+
+	for(auto &Conn : m_aConnections)
+	{
+		if(Conn.m_State != CConnection::STATE_EMPTY)
+			Drop(&Conn);
+	}
+
+	net_tcp_close(m_Socket);
+	m_Socket = nullptr;
+	m_Ready = false;
+}
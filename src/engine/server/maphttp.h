@@ -0,0 +1,102 @@
+#ifndef ENGINE_SERVER_MAPHTTP_H
+#define ENGINE_SERVER_MAPHTTP_H
+
+#include <base/hash.h>
+#include <base/system.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+class IConsole;
+class CNetBan;
+
+/*
+	Class: CMapHttpServer
+		Minimal HTTP/1.1 file server for the loaded maps, so that clients
+		with http map download don't take the map over the game socket.
+		Maps are served by the hex SHA256 at the end of the path, which
+		matches the "<name>_<sha256>.map" urls clients build themselves.
+		One request per connection, driven from the server loop.
+*/
+class CMapHttpServer
+{
+	enum
+	{
+		MAX_CONNECTIONS = 16,
+		MAX_REQUEST_SIZE = 2048,
+		TIMEOUT = 10,
+	};
+
+	class CConnection
+	{
+	public:
+		enum
+		{
+			STATE_EMPTY = 0,
+			STATE_REQUEST,
+			STATE_RESPONSE,
+		};
+
+		int m_State;
+		NETSOCKET m_Socket;
+		NETADDR m_Addr;
+		int64_t m_LastActivity;
+
+		char m_aRequest[MAX_REQUEST_SIZE];
+		int m_RequestSize;
+
+		char m_aHeader[256];
+		int m_HeaderSize;
+		const unsigned char *m_pBody;
+		int m_BodySize;
+		int m_Sent;
+	};
+
+	struct SMap
+	{
+		const unsigned char *m_pData;
+		unsigned m_Size;
+	};
+
+	IConsole *m_pConsole;
+	CNetBan *m_pNetBan;
+	NETSOCKET m_Socket;
+	bool m_Ready;
+	// <address>:<port> of a concrete bind address, empty for wildcard or loopback ones
+	char m_aBindUrl[NETADDR_MAXSTRSIZE];
+
+	CConnection m_aConnections[MAX_CONNECTIONS];
+
+	// maps are added by the map loading thread too
+	std::mutex m_MapsLock;
+	std::map<std::string, SMap> m_Maps;
+
+	int64_t m_BytesSent;
+	int m_NumRequests;
+
+	void Accept();
+	void HandleRequest(CConnection *pConn);
+	void Respond(CConnection *pConn, int Status, const char *pStatus, const unsigned char *pBody, int BodySize, bool HeadOnly);
+	void Drop(CConnection *pConn);
+
+public:
+	CMapHttpServer();
+	IConsole *Console() { return m_pConsole; }
+
+	void Init(IConsole *pConsole, CNetBan *pNetBan);
+	void Update();
+	void Shutdown();
+
+	bool IsReady() const { return m_Ready; }
+
+	// the data has to stay valid as long as the server runs
+	void AddMap(const SHA256_DIGEST &Sha256, const unsigned char *pData, unsigned Size);
+	// empty when the server isn't running or clients have no address to reach it by
+	void GetMapUrl(const char *pMapName, const SHA256_DIGEST &Sha256, char *pBuf, int BufSize) const;
+
+	int64_t BytesSent() const { return m_BytesSent; }
+	int NumRequests() const { return m_NumRequests; }
+};
+
+#endif
@@ -28,11 +28,14 @@
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 #include <engine/shared/packer.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/protocol7.h>
 #include <engine/shared/protocol_ex.h>
 #include <engine/shared/snapshot.h>
+#include <engine/shared/teehistorian_ex.h>
 
+#include <generated/protocol.h>
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
 
@@ -49,7 +52,9 @@
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <thread>
 
 #include <signal.h>
 
@@ -331,9 +336,17 @@ CServer::CServer() : m_DemoRecorder(&m_SnapshotDelta)
 
 	m_Active = false;
 
+	mem_zero(&m_LoadShedStats, sizeof(m_LoadShedStats));
+	m_LoadShedLevel = LOADSHED_NONE;
+	m_OverrunStreak = 0;
+	m_HealthyStreak = 0;
+
 	m_pMainMapData = nullptr;
 	m_pMenuMapData = nullptr;
 
+	m_Replaying = false;
+	mem_zero(m_aNumReplaySeedsUsed, sizeof(m_aNumReplaySeedsUsed));
+
 	Init();
 }
 
@@ -630,6 +643,9 @@ int CServer::MaxClients() const
 	return m_NetServer.MaxClients();
 }
 
+// payload of one NETMSG_MAP_DATA message
+static const unsigned MAP_CHUNK_SIZE = 1024 - 128;
+
 static inline bool RepackMsg(const CMsgPacker *pMsg, CPacker &Packer, bool Sixup)
 {
 	int MsgId = pMsg->m_MsgID;
@@ -685,6 +701,10 @@ static inline bool RepackMsg(const CMsgPacker *pMsg, CPacker &Packer, bool Sixup
 
 int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 {
+	// the replayed clients have no connection, only the demo gets the message
+	if(m_Replaying)
+		Flags |= MSGFLAG_NOSEND;
+
 	CNetChunk Packet;
 	mem_zero(&Packet, sizeof(CNetChunk));
 	if(Flags & MSGFLAG_VITAL)
@@ -749,6 +769,8 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 
 void CServer::DoSnapshot()
 {
+	PROFILE_SCOPE(PROFILE_SNAPSHOT);
+
 	GameServer()->OnPreSnap();
 
 	// create snapshot for demo recording
@@ -774,7 +796,7 @@ void CServer::DoSnapshot()
 			continue;
 
 		// this client is trying to recover, don't spam snapshots
-		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_RECOVER && (Tick()%50) != 0)
+		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_RECOVER && (Tick() % (m_LoadShedLevel >= LOADSHED_SNAPSHOTS ? 100 : 50)) != 0)
 			continue;
 
 		// this client is trying to recover, don't spam snapshots
@@ -782,14 +804,19 @@ void CServer::DoSnapshot()
 			continue;
 
 		{
-			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
-
-			GameServer()->OnSnap(i);
-
-			// finish snapshot
 			char aData[CSnapshot::MAX_SIZE];
 			CSnapshot *pData = (CSnapshot *)aData; // Fix compiler warning for strict-aliasing
-			int SnapshotSize = m_SnapshotBuilder.Finish(pData);
+			int SnapshotSize;
+			{
+				PROFILE_SCOPE(PROFILE_SNAP_BUILD);
+
+				m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
+
+				GameServer()->OnSnap(i);
+
+				// finish snapshot
+				SnapshotSize = m_SnapshotBuilder.Finish(pData);
+			}
 
 			int Crc = pData->Crc();
 
@@ -819,7 +846,11 @@ void CServer::DoSnapshot()
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
 			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+			int DeltaSize;
+			{
+				PROFILE_SCOPE(PROFILE_SNAP_DELTA);
+				DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+			}
 
 			if(DeltaSize)
 			{
@@ -827,7 +858,10 @@ void CServer::DoSnapshot()
 				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
 
 				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+				{
+					PROFILE_SCOPE(PROFILE_SNAP_COMPRESS);
+					SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+				}
 				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
 
 				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
@@ -909,6 +943,8 @@ int CServer::NewClientNoAuthCallback(int ClientID, void *pUser)
 	memset(&pThis->m_aClients[ClientID].m_Addr, 0, sizeof(NETADDR));
 	pThis->m_aClients[ClientID].Reset();
 
+	pThis->m_TeeHistorian.RecordJoin(pThis->m_CurrentGameTick, ClientID, false, true);
+
 	pThis->SendCapabilities(ClientID);
 	pThis->SendMap(ClientID);
 
@@ -936,6 +972,8 @@ int CServer::NewClientCallback(int ClientID, void *pUser, bool Sixup)
 	pThis->m_aClients[ClientID].m_Sixup = Sixup;
 	pThis->m_aClients[ClientID].m_InMenu = pThis->m_pMenuMapData;
 
+	pThis->m_TeeHistorian.RecordJoin(pThis->m_CurrentGameTick, ClientID, Sixup, false);
+
 	return 0;
 }
 
@@ -950,6 +988,9 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "client dropped. cid=%d addr=%s reason='%s'", ClientID, aAddrStr,	pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
 
+	if(pThis->m_aClients[ClientID].m_State != CClient::STATE_EMPTY)
+		pThis->m_TeeHistorian.RecordDrop(pThis->m_CurrentGameTick, ClientID, pReason);
+
 	// notify the mod about the drop
 	if(pThis->m_aClients[ClientID].m_State >= CClient::STATE_READY)
 		pThis->GameServer()->OnClientDrop(ClientID, pReason);
@@ -999,7 +1040,9 @@ void CServer::SendMap(int ClientID)
 		Msg.AddRaw(&pMapData->m_MapSha256.data, sizeof(pMapData->m_MapSha256.data));
 		Msg.AddInt(pMapData->m_MapCrc);
 		Msg.AddInt(pMapData->m_MapSize);
-		Msg.AddString("", 0); // HTTPS map download URL
+		char aUrl[256];
+		m_MapHttp.GetMapUrl(GetMapName(pMapData), pMapData->m_MapSha256, aUrl, sizeof(aUrl));
+		Msg.AddString(aUrl, 0); // HTTPS map download URL
 		SendMsg(&Msg, MSGFLAG_VITAL, ClientID);
 	}
 	{
@@ -1010,7 +1053,7 @@ void CServer::SendMap(int ClientID)
 		if(IsSixup(ClientID))
 		{
 			Msg.AddInt(g_Config.m_SvMapWindow);
-			Msg.AddInt(1024 - 128);
+			Msg.AddInt(MAP_CHUNK_SIZE);
 			Msg.AddRaw(&pMapData->m_MapSha256.data, sizeof(pMapData->m_MapSha256.data));
 		}
 		SendMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_FLUSH, ClientID);
@@ -1019,17 +1062,14 @@ void CServer::SendMap(int ClientID)
 	m_aClients[ClientID].m_NextMapChunk = 0;
 }
 
-void CServer::SendMapData(int ClientID, int Chunk)
+bool CServer::PackMapDataChunk(const CMapData *pMapData, int Chunk, bool Sixup, CPacker *pPacker)
 {
-	CMapData *pMapData = m_aClients[ClientID].m_pMapData;
-
-	unsigned int ChunkSize = 1024 - 128;
+	unsigned int ChunkSize = MAP_CHUNK_SIZE;
 	unsigned int Offset = Chunk * ChunkSize;
 	int Last = 0;
 
-	// drop faulty map data requests
 	if(Chunk < 0 || Offset > pMapData->m_MapSize)
-		return;
+		return false;
 
 	if(Offset + ChunkSize >= pMapData->m_MapSize)
 	{
@@ -1038,7 +1078,7 @@ void CServer::SendMapData(int ClientID, int Chunk)
 	}
 
 	CMsgPacker Msg(NETMSG_MAP_DATA, true);
-	if(!IsSixup(ClientID))
+	if(!Sixup)
 	{
 		Msg.AddInt(Last);
 		Msg.AddInt(pMapData->m_MapCrc);
@@ -1046,12 +1086,63 @@ void CServer::SendMapData(int ClientID, int Chunk)
 		Msg.AddInt(ChunkSize);
 	}
 	Msg.AddRaw(&pMapData->m_pMapData[Offset], ChunkSize);
-	SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH, ClientID);
+	return !RepackMsg(&Msg, *pPacker, Sixup);
+}
+
+void CServer::PackMapDataChunks(CMapData *pMapData)
+{
+	int NumChunks = pMapData->m_pMapData ? pMapData->m_MapSize / MAP_CHUNK_SIZE + 1 : 0;
+	for(int Sixup = 0; Sixup < 2; Sixup++)
+	{
+		std::vector<unsigned char> &vData = pMapData->m_aChunkData[Sixup];
+		std::vector<unsigned> &vOffsets = pMapData->m_aChunkOffsets[Sixup];
+		vData.clear();
+		vOffsets.clear();
+		vData.reserve(pMapData->m_MapSize + NumChunks * 16);
+		vOffsets.reserve(NumChunks + 1);
+
+		CPacker Packer;
+		for(int Chunk = 0; Chunk < NumChunks; Chunk++)
+		{
+			vOffsets.push_back(vData.size());
+			if(PackMapDataChunk(pMapData, Chunk, Sixup, &Packer))
+				vData.insert(vData.end(), Packer.Data(), Packer.Data() + Packer.Size());
+		}
+		vOffsets.push_back(vData.size());
+	}
+}
+
+void CServer::SendMapData(int ClientID, int Chunk)
+{
+	if(m_Replaying)
+		return;
+
+	const CMapData *pMapData = m_aClients[ClientID].m_pMapData;
+	bool Sixup = IsSixup(ClientID);
+
+	// drop faulty map data requests
+	int NumChunks = (int)pMapData->m_aChunkOffsets[Sixup].size() - 1;
+	if(Chunk < 0 || Chunk >= NumChunks)
+		return;
+
+	// the chunks are packed in LoadMap, only hand them to the network here
+	unsigned Offset = pMapData->m_aChunkOffsets[Sixup][Chunk];
+	unsigned Size = pMapData->m_aChunkOffsets[Sixup][Chunk + 1] - Offset;
+
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(CNetChunk));
+	Packet.m_ClientID = ClientID;
+	Packet.m_Flags = NETSENDFLAG_VITAL | NETSENDFLAG_FLUSH;
+	Packet.m_pData = &pMapData->m_aChunkData[Sixup][Offset];
+	Packet.m_DataSize = Size;
+
+	m_DemoRecorder.RecordMessage(Packet.m_pData, Packet.m_DataSize);
+	m_NetServer.Send(&Packet);
 
 	if(g_Config.m_Debug)
 	{
 		char aBuf[256];
-		str_format(aBuf, sizeof(aBuf), "sending chunk %d with size %d", Chunk, ChunkSize);
+		str_format(aBuf, sizeof(aBuf), "sending chunk %d with size %d", Chunk, Size);
 		Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "server", aBuf);
 	}
 }
@@ -1168,6 +1259,14 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 		SendMsg(&Packer, MSGFLAG_VITAL, ClientID);
 	}
 
+	if(m_TeeHistorian.IsRecording())
+	{
+		// map download and pings don't change the game, rcon and chat may carry passwords
+		bool Skip = Sys ? (Msg == NETMSG_REQUEST_MAP_DATA || Msg == NETMSG_PING || Msg == NETMSG_RCON_AUTH || Msg == NETMSG_RCON_CMD) : Msg == (IsSixup(ClientID) ? (int)protocol7::NETMSGTYPE_CL_SAY : (int)NETMSGTYPE_CL_SAY);
+		if(!Skip)
+			m_TeeHistorian.RecordMessage(m_CurrentGameTick, ClientID, pPacket->m_Flags, pPacket->m_pData, pPacket->m_DataSize);
+	}
+
 	//if(Msg != NETMSG_INPUT && Msg != NETMSG_REQUEST_MAP_DATA)
 	//	dbg_msg("debug", "packet %d of client=%d, state=%d, ready=%d", Msg, ClientID, m_aClients[ClientID].m_State, GameServer()->IsClientReady(ClientID));
 
@@ -1849,6 +1948,9 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
+	if(m_Replaying)
+		return;
+
 	CPacker p;
 	char aBuf[128];
 	p.Reset();
@@ -2108,6 +2210,8 @@ void CServer::UpdateServerInfo(bool Resend)
 
 void CServer::PumpNetwork(bool PacketWaiting)
 {
+	PROFILE_SCOPE(PROFILE_PUMP_NETWORK);
+
 	CNetChunk Packet;
 	SECURITY_TOKEN ResponseToken;
 
@@ -2187,6 +2291,7 @@ void CServer::PumpNetwork(bool PacketWaiting)
 
 	m_ServerBan.Update();
 	m_Econ.Update();
+	m_MapHttp.Update();
 }
 
 int* CServer::GetIdMap(int ClientID)
@@ -2253,20 +2358,18 @@ int CServer::LoadMap(const char *pMapName)
 	str_copy(MapData.m_aMap, pMapName, sizeof(MapData.m_aMap));
 	//map_set(df);
 
-	// load complete map into memory for download
+	// the download comes from the file the map was loaded from, no second read
 	{
-		free(MapData.m_pMapData);
-		void *pData;
-		Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &MapData.m_MapSize);
-		MapData.m_pMapData = (unsigned char *)pData;
-
-		MapData.m_MapSha256 = sha256(MapData.m_pMapData, MapData.m_MapSize);
-		
-		// get the crc of the map
+		MapData.m_pMapData = MapData.m_pMap->FileData();
+		MapData.m_MapSize = MapData.m_pMap->FileSize();
+		MapData.m_MapSha256 = MapData.m_pMap->Sha256();
 		MapData.m_MapCrc = MapData.m_pMap->Crc();
+
+		PackMapDataChunks(&MapData);
+		m_MapHttp.AddMap(MapData.m_MapSha256, MapData.m_pMapData, MapData.m_MapSize);
 	}
 
-	m_MapDatas[Uuid] = MapData;
+	m_MapDatas[Uuid] = std::move(MapData);
 
 	if(Menu && !m_pMenuMapData)
 		m_pMenuMapData = &m_MapDatas[Uuid];
@@ -2278,8 +2381,16 @@ int CServer::LoadMap(const char *pMapName)
 
 int CServer::GenerateMap(const char *pMapName)
 {
+	// a loaded map keeps its file mapped and in use, the new file couldn't
+	// replace it on every platform and LoadMap wouldn't pick it up anyway
+	if(m_MapDatas.count(CalculateUuid(pMapName)))
+	{
+		log_warn("server", "map '%s' is loaded, not generating it again", pMapName);
+		return 1;
+	}
+
 	CMapGen MapGen(Storage(), Console(), this);
-	
+
 	if(!MapGen.CreateMap(pMapName, true))
 		return 0;
 
@@ -2321,6 +2432,30 @@ void CServer::CreateMapThread(const char *pMapName)
 	Thread.detach();
 }
 
+// ex chunks of the session seeds, by IServer::SEED_*
+static const int s_aSeedChunks[IServer::NUM_SEEDS] = {TEEHISTORIAN_MAP_SEED, TEEHISTORIAN_BOT_SEED, TEEHISTORIAN_WORLD_SEED};
+
+void CServer::RunGameTick()
+{
+	// apply new input
+	for(int c = 0; c < g_Config.m_SvMaxClients; c++)
+	{
+		if(m_aClients[c].m_State != CClient::STATE_INGAME)
+			continue;
+		for(auto &Input : m_aClients[c].m_aInputs)
+		{
+			if(Input.m_GameTick == Tick())
+			{
+				GameServer()->OnClientPredictedInput(c, Input.m_aData);
+				break;
+			}
+		}
+	}
+
+	PROFILE_SCOPE(PROFILE_TICK);
+	GameServer()->OnTick();
+}
+
 int CServer::Run()
 {
 	//
@@ -2328,6 +2463,23 @@ int CServer::Run()
 	
 	m_MainMapLoaded = false;
 
+	if(g_Config.m_SvTeeHistorianReplay[0])
+	{
+		if(!m_TeeHistorianReplay.Open(Storage(), g_Config.m_SvTeeHistorianReplay))
+		{
+			log_error("teehistorian", "failed to open recording '%s'", g_Config.m_SvTeeHistorianReplay);
+			return -1;
+		}
+		log_info("teehistorian", "replaying '%s' %s", g_Config.m_SvTeeHistorianReplay, m_TeeHistorianReplay.Header());
+
+		// the seeds are read before the map generation asks for them
+		for(int i = 0; i < NUM_SEEDS; i++)
+			m_TeeHistorianReplay.Seeds(s_aSeedChunks[i], &m_avReplaySeeds[i]);
+		m_Replaying = true;
+	}
+	else if(g_Config.m_SvTeeHistorian)
+		StartTeeHistorian();
+
 	CMapGen MapGen(Storage(), Console(), this);
 	
 	if(!MapGen.CreateMenu("menu"))
@@ -2338,6 +2490,9 @@ int CServer::Run()
 	// load map
 	CreateMapThread("moon");
 
+	if(m_Replaying)
+		return RunReplay();
+
 	// start server
 	NETADDR BindAddr;
 	if(g_Config.m_Bindaddr[0] && net_host_lookup(g_Config.m_Bindaddr, &BindAddr, NETTYPE_ALL) == 0)
@@ -2369,6 +2524,7 @@ int CServer::Run()
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
 
 	m_Econ.Init(Console(), &m_ServerBan);
+	m_MapHttp.Init(Console(), &m_ServerBan);
 
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "===========================================");
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "+   |                     -----           +");
@@ -2436,22 +2592,7 @@ int CServer::Run()
 				m_CurrentGameTick++;
 				NewTicks++;
 
-				// apply new input
-				for(int c = 0; c < g_Config.m_SvMaxClients; c++)
-				{
-					if(m_aClients[c].m_State != CClient::STATE_INGAME)
-						continue;
-					for(auto &Input : m_aClients[c].m_aInputs)
-					{
-						if(Input.m_GameTick == Tick())
-						{
-							GameServer()->OnClientPredictedInput(c, Input.m_aData);
-							break;
-						}
-					}
-				}
-
-				GameServer()->OnTick();
+				RunGameTick();
 			}
 
 			// snap game
@@ -2461,6 +2602,10 @@ int CServer::Run()
 					DoSnapshot();
 
 				UpdateClientRconCommands();
+
+				UpdateLoadShedding(NewTicks, time_get() - t);
+
+				m_TeeHistorian.Flush();
 			}
 
 			// master server stuff
@@ -2473,6 +2618,9 @@ int CServer::Run()
 			if(m_MainMapLoaded && m_Active)
 				PumpNetwork(PacketWaiting);
 
+			if(CProfiler::Enabled())
+				CProfiler::Collect();
+
 			m_Active = false;
 
 			for(int i = 0;i < MAX_CLIENTS;i ++)
@@ -2532,17 +2680,191 @@ int CServer::Run()
 
 		m_Econ.Shutdown();
 	}
+	m_MapHttp.Shutdown();
+	m_TeeHistorian.Stop();
 
 	GameServer()->OnShutdown();
 
+	CProfiler::StopTrace();
+
 	m_pRegister->OnShutdown();
 	
 	for(auto &Data : m_MapDatas)
 	{
 		Data.second.m_pMap->Unload();
+	}
+	return 0;
+}
+
+uint64_t CServer::SessionSeed(int Type, uint64_t Seed)
+{
+	if(m_Replaying)
+	{
+		// the maps are generated on their own threads, so the seeds can't be
+		// matched by tick. Each type is asked for in the recorded order though
+		std::lock_guard<std::mutex> Lock(m_ReplaySeedsLock);
+		if(m_aNumReplaySeedsUsed[Type] >= m_avReplaySeeds[Type].size())
+		{
+			log_warn("teehistorian", "recording has no more seeds of type %d, the replay diverges", Type);
+			return Seed;
+		}
+		return m_avReplaySeeds[Type][m_aNumReplaySeedsUsed[Type]++];
+	}
 
-		if(Data.second.m_pMapData)
-			free(Data.second.m_pMapData);
+	m_TeeHistorian.RecordSeed(m_CurrentGameTick, s_aSeedChunks[Type], Seed);
+	return Seed;
+}
+
+void CServer::StartTeeHistorian()
+{
+	Storage()->CreateFolder("teehistorian", IStorage::TYPE_SAVE);
+
+	char aTimestamp[64];
+	str_timestamp(aTimestamp, sizeof(aTimestamp));
+	char aFilename[IO_MAX_PATH_LENGTH];
+	str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian", aTimestamp);
+
+	if(!m_TeeHistorian.Start(Storage(), aFilename, GameServer()->GameType(), GameServer()->NetVersion()))
+	{
+		log_error("teehistorian", "failed to open '%s' for writing", aFilename);
+		return;
+	}
+	log_info("teehistorian", "recording to '%s'", aFilename);
+}
+
+void CServer::ReplayRecord(const CTeeHistorianReader::CRecord &Record)
+{
+	switch(Record.m_Type)
+	{
+	case CTeeHistorian::RECORD_EX:
+		if(Record.m_ExID == TEEHISTORIAN_JOINVER6 || Record.m_ExID == TEEHISTORIAN_JOINVER7)
+		{
+			int ClientID = -1;
+			int NoAuth = 0;
+			const unsigned char *pData = CVariableInt::Unpack(Record.m_pData, &ClientID, Record.m_Size);
+			if(pData)
+				CVariableInt::Unpack(pData, &NoAuth, Record.m_pData + Record.m_Size - pData);
+			if(ClientID < 0 || ClientID >= MAX_CLIENTS)
+				break;
+
+			if(NoAuth)
+				NewClientNoAuthCallback(ClientID, this);
+			else
+				NewClientCallback(ClientID, this, Record.m_ExID == TEEHISTORIAN_JOINVER7);
+		}
+		break;
+
+	case CTeeHistorian::RECORD_DROP:
+		if(Record.m_ClientID >= 0 && Record.m_ClientID < MAX_CLIENTS && m_aClients[Record.m_ClientID].m_State != CClient::STATE_EMPTY)
+			DelClientCallback(Record.m_ClientID, (const char *)Record.m_pData, this);
+		break;
+
+	case CTeeHistorian::RECORD_MESSAGE:
+		if(Record.m_ClientID >= 0 && Record.m_ClientID < MAX_CLIENTS && m_aClients[Record.m_ClientID].m_State != CClient::STATE_EMPTY)
+		{
+			CNetChunk Packet;
+			mem_zero(&Packet, sizeof(Packet));
+			Packet.m_ClientID = Record.m_ClientID;
+			Packet.m_Flags = Record.m_Flags;
+			Packet.m_DataSize = Record.m_Size;
+			Packet.m_pData = Record.m_pData;
+			ProcessClientPacket(&Packet);
+		}
+		break;
+	}
+}
+
+int CServer::RunReplay()
+{
+	// no socket is opened, SendMsg, SendMapData and SendServerInfo drop what
+	// the game sends while replaying
+	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
+
+	GameServer()->OnInit();
+	m_pConsole->StoreCommands(false);
+
+	while(!m_MainMapLoaded && m_RunServer && !InterruptSignaled)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	// replay the recorded ticks back to back, only the work of each tick is timed
+	std::vector<int64_t> vTickTimes;
+	std::vector<uint64_t> vChecksums;
+	CTeeHistorianReader::CRecord Record;
+	bool HasRecord = m_TeeHistorianReplay.Next(&Record);
+	while(HasRecord && m_RunServer && !InterruptSignaled)
+	{
+		while(HasRecord && Record.m_Tick <= m_CurrentGameTick)
+		{
+			ReplayRecord(Record);
+			HasRecord = m_TeeHistorianReplay.Next(&Record);
+		}
+
+		int64_t Start = time_get();
+		m_CurrentGameTick++;
+		RunGameTick();
+		if(g_Config.m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0)
+			DoSnapshot();
+		vTickTimes.push_back(time_get() - Start);
+		if(g_Config.m_SvWorldChecksum)
+			vChecksums.push_back(GameServer()->WorldChecksum());
+	}
+
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
+			DelClientCallback(i, "Replay finished", this);
+	}
+
+	if(g_Config.m_SvTeeHistorianReport[0])
+	{
+		IOHANDLE File = Storage()->OpenFile(g_Config.m_SvTeeHistorianReport, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(File)
+		{
+			char aLine[64];
+			str_copy(aLine, vChecksums.empty() ? "tick,time_us\n" : "tick,time_us,checksum\n");
+			io_write(File, aLine, str_length(aLine));
+			for(size_t i = 0; i < vTickTimes.size(); i++)
+			{
+				if(vChecksums.empty())
+					str_format(aLine, sizeof(aLine), "%d,%lld\n", (int)i + 1, (long long)(vTickTimes[i] * 1000000 / time_freq()));
+				else
+					str_format(aLine, sizeof(aLine), "%d,%lld,%016llx\n", (int)i + 1, (long long)(vTickTimes[i] * 1000000 / time_freq()), (unsigned long long)vChecksums[i]);
+				io_write(File, aLine, str_length(aLine));
+			}
+			io_close(File);
+		}
+		else
+			log_error("teehistorian", "failed to open '%s' for writing", g_Config.m_SvTeeHistorianReport);
+	}
+
+	if(!vTickTimes.empty())
+	{
+		int64_t Total = 0;
+		for(int64_t Time : vTickTimes)
+			Total += Time;
+		std::sort(vTickTimes.begin(), vTickTimes.end());
+		auto Ms = [](int64_t Time) { return Time * 1000.0f / time_freq(); };
+		log_info("teehistorian", "replayed %d ticks: mean=%.3fms p50=%.3fms p99=%.3fms max=%.3fms",
+			(int)vTickTimes.size(), Ms(Total / (int64_t)vTickTimes.size()), Ms(vTickTimes[vTickTimes.size() / 2]),
+			Ms(vTickTimes[vTickTimes.size() * 99 / 100]), Ms(vTickTimes.back()));
+	}
+	else
+		log_info("teehistorian", "recording holds no ticks");
+
+	if(!vChecksums.empty())
+	{
+		// one value to compare two replays of the same recording by
+		uint64_t Checksum = 0;
+		for(uint64_t TickChecksum : vChecksums)
+			Checksum = (Checksum << 1 | Checksum >> 63) ^ TickChecksum;
+		log_info("teehistorian", "world checksum %016llx, last tick %016llx", (unsigned long long)Checksum, (unsigned long long)vChecksums.back());
+	}
+
+	GameServer()->OnShutdown();
+
+	for(auto &Data : m_MapDatas)
+	{
+		Data.second.m_pMap->Unload();
 	}
 	return 0;
 }
@@ -2598,7 +2920,7 @@ void CServer::DemoRecorder_HandleAutoStart()
 		char aDate[20];
 		str_timestamp(aDate, sizeof(aDate));
 		str_format(aFilename, sizeof(aFilename), "demos/%s_%s.demo", "auto/autorecord", aDate);
-		m_DemoRecorder.Start(Storage(), m_pConsole, aFilename, "0.6 626fce9a778df4d4", m_pMainMapData->m_aMap, m_pMainMapData->m_MapCrc, "server");
+		m_DemoRecorder.Start(Storage(), m_pConsole, aFilename, "0.6 626fce9a778df4d4", m_pMainMapData->m_aMap, m_pMainMapData->m_MapCrc, "server", g_Config.m_SvDemoAsync);
 		if(g_Config.m_SvAutoDemoMax)
 		{
 			// clean up auto recorded demos
@@ -2626,7 +2948,7 @@ void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 		str_timestamp(aDate, sizeof(aDate));
 		str_format(aFilename, sizeof(aFilename), "demos/demo_%s.demo", aDate);
 	}
-	pServer->m_DemoRecorder.Start(pServer->Storage(), pServer->Console(), aFilename, "0.6 626fce9a778df4d4", pServer->m_pMainMapData->m_aMap, pServer->m_pMainMapData->m_MapCrc, "server");
+	pServer->m_DemoRecorder.Start(pServer->Storage(), pServer->Console(), aFilename, "0.6 626fce9a778df4d4", pServer->m_pMainMapData->m_aMap, pServer->m_pMainMapData->m_MapCrc, "server", g_Config.m_SvDemoAsync);
 }
 
 void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
@@ -2722,6 +3044,164 @@ void CServer::ConchainConsoleOutputLevelUpdate(IConsole::IResult *pResult, void
 	}
 }
 
+void CServer::UpdateLoadShedding(int NewTicks, int64_t WorkTime)
+{
+	m_LoadShedStats.m_LastWorkTime = WorkTime;
+	m_LoadShedStats.m_MaxWorkTime = maximum(m_LoadShedStats.m_MaxWorkTime, WorkTime);
+	m_LoadShedStats.m_aLevelTicks[m_LoadShedLevel] += NewTicks;
+
+	// only the work itself counts, catching up after the idle sleep in
+	// net_socket_read_wait runs many cheap ticks at once and isn't an overrun
+	int64_t TickTime = time_freq() / TickSpeed();
+	int64_t Budget = TickTime * NewTicks;
+	bool Overrun = WorkTime > Budget;
+	if(NewTicks > 1)
+		m_LoadShedStats.m_CatchupTicks += NewTicks - 1;
+
+	if(Overrun)
+	{
+		m_LoadShedStats.m_OverrunTicks += NewTicks;
+		m_OverrunStreak += NewTicks;
+		m_HealthyStreak = 0;
+	}
+	else
+	{
+		m_OverrunStreak = 0;
+		// only recover once there is real slack left, otherwise the levels flap
+		if(WorkTime < Budget / 2)
+			m_HealthyStreak += NewTicks;
+		else
+			m_HealthyStreak = 0;
+	}
+
+	if(!g_Config.m_SvLoadShed)
+	{
+		if(m_LoadShedLevel != LOADSHED_NONE)
+			SetLoadShedLevel(LOADSHED_NONE, WorkTime);
+		return;
+	}
+
+	if(m_OverrunStreak >= g_Config.m_SvLoadShedOverrunTicks && m_LoadShedLevel < NUM_LOADSHED_LEVELS - 1)
+		SetLoadShedLevel(m_LoadShedLevel + 1, WorkTime);
+	else if(m_HealthyStreak >= g_Config.m_SvLoadShedRecoverTicks && m_LoadShedLevel > LOADSHED_NONE)
+		SetLoadShedLevel(m_LoadShedLevel - 1, WorkTime);
+}
+
+void CServer::SetLoadShedLevel(int Level, int64_t WorkTime)
+{
+	static const char *s_apLevelNames[NUM_LOADSHED_LEVELS] = {"none", "bot_ai", "idle_worlds", "snapshots", "bot_spawn"};
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "load shedding %s: level %d (%s) -> %d (%s), tick work %.3fms",
+		Level > m_LoadShedLevel ? "raised" : "lowered", m_LoadShedLevel, s_apLevelNames[m_LoadShedLevel],
+		Level, s_apLevelNames[Level], WorkTime * 1000.0f / time_freq());
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "watchdog", aBuf);
+
+	m_LoadShedLevel = Level;
+	m_LoadShedStats.m_LevelChanges++;
+	m_OverrunStreak = 0;
+	m_HealthyStreak = 0;
+}
+
+void CServer::ConLoadShedStatus(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	const CLoadShedStats &Stats = pThis->m_LoadShedStats;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "level=%d overrun_ticks=%lld catchup_ticks=%lld level_changes=%lld",
+		pThis->m_LoadShedLevel, (long long)Stats.m_OverrunTicks, (long long)Stats.m_CatchupTicks, (long long)Stats.m_LevelChanges);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "watchdog", aBuf);
+	str_format(aBuf, sizeof(aBuf), "work=%.3fms max_work=%.3fms tick=%.3fms",
+		Stats.m_LastWorkTime * 1000.0f / time_freq(), Stats.m_MaxWorkTime * 1000.0f / time_freq(), 1000.0f / pThis->TickSpeed());
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "watchdog", aBuf);
+	str_format(aBuf, sizeof(aBuf), "ticks per level: %lld %lld %lld %lld %lld", (long long)Stats.m_aLevelTicks[0],
+		(long long)Stats.m_aLevelTicks[1], (long long)Stats.m_aLevelTicks[2], (long long)Stats.m_aLevelTicks[3], (long long)Stats.m_aLevelTicks[4]);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "watchdog", aBuf);
+
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+		mem_zero(&pThis->m_LoadShedStats, sizeof(pThis->m_LoadShedStats));
+}
+
+void CServer::ConchainProfileUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	CProfiler::SetEnabled(g_Config.m_DbgProfile);
+}
+
+void CServer::ConProfile(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+
+	if(!CProfiler::Enabled())
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "profiler is disabled, enable it with dbg_profile 1");
+		return;
+	}
+
+	CProfiler::Collect();
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%-20s %10s %10s %10s %10s", "zone", "count", "p50(ms)", "p99(ms)", "max(ms)");
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", aBuf);
+	for(int i = 0; i < NUM_PROFILE_ZONES; i++)
+	{
+		CProfiler::CZoneStats Stats;
+		CProfiler::GetStats(i, &Stats);
+		if(!Stats.m_Count)
+			continue;
+
+		str_format(aBuf, sizeof(aBuf), "%-20s %10lld %10.3f %10.3f %10.3f", CProfiler::ZoneName(i), (long long)Stats.m_Count,
+			Stats.m_P50 * 1000.0f / time_freq(), Stats.m_P99 * 1000.0f / time_freq(), Stats.m_Max * 1000.0f / time_freq());
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", aBuf);
+	}
+}
+
+void CServer::ConProfileReset(IConsole::IResult *pResult, void *pUser)
+{
+	CProfiler::Reset();
+}
+
+void CServer::ConProfileTrace(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+
+	if(!pResult->NumArguments())
+	{
+		if(CProfiler::Tracing())
+		{
+			CProfiler::StopTrace();
+			pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "trace stopped");
+		}
+		return;
+	}
+
+	// only a file in dumps/, rcon must not write elsewhere
+	if(!str_valid_filename(pResult->GetString(0)))
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "invalid trace file name");
+		return;
+	}
+
+	char aFilename[IO_MAX_PATH_LENGTH];
+	str_format(aFilename, sizeof(aFilename), "dumps/%s", pResult->GetString(0));
+	if(!CProfiler::StartTrace(pThis->Storage()->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE)))
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "couldn't open the trace file");
+		return;
+	}
+
+	if(!g_Config.m_DbgProfile)
+	{
+		g_Config.m_DbgProfile = 1;
+		CProfiler::SetEnabled(true);
+	}
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "tracing to '%s'", aFilename);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", aBuf);
+}
+
 void CServer::RegisterCommands()
 {
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
@@ -2741,12 +3221,19 @@ void CServer::RegisterCommands()
 
 	Console()->Register("new_map", "r", CFGFLAG_SERVER, ConNewMap, this, "Create new map");
 
+	Console()->Register("loadshed_status", "?i", CFGFLAG_SERVER, ConLoadShedStatus, this, "Show the tick watchdog stats (1 = reset them)");
+
+	Console()->Register("profile", "", CFGFLAG_SERVER, ConProfile, this, "Show tick timings per subsystem (needs dbg_profile 1)");
+	Console()->Register("profile_reset", "", CFGFLAG_SERVER, ConProfileReset, this, "Reset the tick timings");
+	Console()->Register("profile_trace", "?s", CFGFLAG_SERVER, ConProfileTrace, this, "Write a chrome trace to the given file, stop it without file");
+
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
 
 	Console()->Chain("sv_max_clients_per_ip", ConchainMaxclientsperipUpdate, this);
 	Console()->Chain("mod_command", ConchainModCommandUpdate, this);
 	Console()->Chain("console_output_level", ConchainConsoleOutputLevelUpdate, this);
+	Console()->Chain("dbg_profile", ConchainProfileUpdate, this);
 	// register console commands in sub parts
 	m_ServerBan.InitServerBan(Console(), Storage(), this);
 	m_pGameServer->OnConsoleInit();
@@ -2934,10 +3421,23 @@ void CServer::ChangeClientMap(int ClientID, CUuid *pMapID)
 	if(m_aClients[ClientID].m_State <= CClient::STATE_AUTH)
 		return;
 
+	CMapData *pOldMapData = m_aClients[ClientID].m_pMapData;
 	m_aClients[ClientID].m_pMapData = &m_MapDatas[*pMapID];
 
 	m_aClients[ClientID].m_InMenu = m_aClients[ClientID].m_pMapData == m_pMenuMapData;
-	
+
+	// the client already has this exact map loaded, move it to the world
+	// without sending it through the map change and the reconnect again.
+	// Worlds are keyed by their map, so that is only the world it is in; a
+	// move to another world needs the other map and takes the full path
+	if(g_Config.m_SvSeamlessTransfer && m_aClients[ClientID].m_State == CClient::STATE_INGAME && pOldMapData &&
+		pOldMapData->m_MapCrc == m_aClients[ClientID].m_pMapData->m_MapCrc &&
+		pOldMapData->m_MapSha256 == m_aClients[ClientID].m_pMapData->m_MapSha256)
+	{
+		GameServer()->OnClientTransfer(ClientID, m_aClients[ClientID].m_pMapData->m_aMap, m_aClients[ClientID].m_InMenu);
+		return;
+	}
+
 	SendMap(ClientID);
 	m_aClients[ClientID].Reset();
 	m_aClients[ClientID].m_State = CClient::STATE_CONNECTING;
@@ -2948,6 +3448,17 @@ int CServer::GetLoadedMapNum() const
 	return (int) m_MapDatas.size();
 }
 
+IMap *CServer::GetLoadedMap(int Index, const char **ppMapName, bool *pMenu)
+{
+	if(Index < 0 || Index >= (int) m_MapDatas.size())
+		return nullptr;
+
+	auto It = std::next(m_MapDatas.begin(), Index);
+	*ppMapName = It->second.m_aMap;
+	*pMenu = &It->second == m_pMenuMapData;
+	return It->second.m_pMap;
+}
+
 int CServer::GetOneWorldPlayerNum(int ClientID) const
 {
 	return m_pGameServer->GetOneWorldPlayerNum(ClientID);
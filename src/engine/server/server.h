@@ -20,9 +20,12 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#include "maphttp.h"
 #include "server_logger.h"
+#include "teehistorian.h"
 
 class CSnapIDPool
 {
@@ -172,6 +175,7 @@ public:
 	CSnapIDPool m_IDPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
+	CMapHttpServer m_MapHttp;
 	CServerBan m_ServerBan;
 
 	int64_t m_GameStartTime;
@@ -194,6 +198,39 @@ public:
 
 	bool m_Active;
 
+	// tick watchdog
+	struct CLoadShedStats
+	{
+		int64_t m_OverrunTicks;
+		int64_t m_CatchupTicks;
+		int64_t m_LastWorkTime;
+		int64_t m_MaxWorkTime;
+		int64_t m_LevelChanges;
+		int64_t m_aLevelTicks[NUM_LOADSHED_LEVELS];
+	};
+	CLoadShedStats m_LoadShedStats;
+	int m_LoadShedLevel;
+	int m_OverrunStreak;
+	int m_HealthyStreak;
+
+	void UpdateLoadShedding(int NewTicks, int64_t WorkTime);
+	void SetLoadShedLevel(int Level, int64_t WorkTime);
+	int LoadShedLevel() const override { return m_LoadShedLevel; }
+
+	// session recording and headless replay
+	CTeeHistorian m_TeeHistorian;
+	CTeeHistorianReader m_TeeHistorianReplay;
+	bool m_Replaying;
+	// every seed of the recording by type, handed out in the order they were asked for
+	std::vector<uint64_t> m_avReplaySeeds[NUM_SEEDS];
+	unsigned m_aNumReplaySeedsUsed[NUM_SEEDS];
+	std::mutex m_ReplaySeedsLock;
+
+	uint64_t SessionSeed(int Type, uint64_t Seed) override;
+	void StartTeeHistorian();
+	void ReplayRecord(const CTeeHistorianReader::CRecord &Record);
+	int RunReplay();
+
 	CServer();
 	~CServer();
 
@@ -243,6 +280,8 @@ public:
 	void SendCapabilities(int ClientID);
 	void SendMap(int ClientID);
 	void SendMapData(int ClientID, int Chunk);
+	static bool PackMapDataChunk(const CMapData *pMapData, int Chunk, bool Sixup, class CPacker *pPacker);
+	static void PackMapDataChunks(CMapData *pMapData);
 	void SendConnectionReady(int ClientID);
 	void SendRconLine(int ClientID, const char *pLine);
 	static void SendRconLineAuthed(const char *pLine, void *pUser);
@@ -298,6 +337,7 @@ class CCache
 
 	bool m_MainMapLoaded;
 
+	void RunGameTick();
 	int Run();
 
 	static void ConKick(IConsole::IResult *pResult, void *pUser);
@@ -313,6 +353,13 @@ class CCache
 
 	static void ConNewMap(IConsole::IResult *pResult, void *pUser);
 
+	static void ConLoadShedStatus(IConsole::IResult *pResult, void *pUser);
+
+	static void ConProfile(IConsole::IResult *pResult, void *pUser);
+	static void ConProfileReset(IConsole::IResult *pResult, void *pUser);
+	static void ConProfileTrace(IConsole::IResult *pResult, void *pUser);
+	static void ConchainProfileUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+
 	void RegisterCommands();
 
 	int SnapNewID() override;
@@ -330,6 +377,7 @@ public:
 
 	void ChangeClientMap(int ClientID, CUuid *pMapID) override;
 	int GetLoadedMapNum() const override;
+	IMap *GetLoadedMap(int Index, const char **ppMapName, bool *pMenu) override;
 
 	int GetOneWorldPlayerNum(int ClientID) const override;
 	void CreateNewTheardJob(std::shared_ptr<IJob> pJob) override;
@@ -0,0 +1,368 @@
+#include <engine/shared/compression.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/teehistorian_ex.h>
+#include <engine/shared/uuid_manager.h>
+#include <engine/storage.h>
+
+#include "teehistorian.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const unsigned char s_aMagic[] = "teehistorian@lunartee";
+const CUuid CTeeHistorian::ms_Magic = CalculateUuid((const char *)s_aMagic);
+
+enum
+{
+	TEEHISTORIAN_VERSION = 1,
+};
+
+CTeeHistorian::CTeeHistorian() :
+	m_File(0),
+	m_LastTick(0),
+	m_pWriterThread(nullptr),
+	m_WriterStop(false)
+{
+}
+
+CTeeHistorian::~CTeeHistorian()
+{
+	Stop();
+}
+
+bool CTeeHistorian::Start(IStorage *pStorage, const char *pFilename, const char *pGameType, const char *pNetVersion)
+{
+	Stop();
+
+	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!m_File)
+		return false;
+
+	char aTimestamp[64];
+	str_timestamp(aTimestamp, sizeof(aTimestamp));
+	char aHeader[512];
+	int HeaderSize = str_format(aHeader, sizeof(aHeader),
+		"{\"version\":\"%d\",\"net_version\":\"%s\",\"game_type\":\"%s\",\"start_time\":\"%s\",\"tick_speed\":\"%d\"}",
+		TEEHISTORIAN_VERSION, pNetVersion, pGameType, aTimestamp, SERVER_TICK_SPEED);
+
+	io_write(m_File, &ms_Magic, sizeof(ms_Magic));
+	io_write(m_File, aHeader, HeaderSize + 1);
+
+	m_LastTick = 0;
+	m_vBuffer.clear();
+	m_vWriting.clear();
+	m_WriterStop = false;
+	sphore_init(&m_WriterSem);
+	m_pWriterThread = thread_init(WriterThread, this, "teehistorian");
+	return true;
+}
+
+void CTeeHistorian::Stop()
+{
+	if(!m_File)
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(m_BufferLock);
+		WriteInt(RECORD_FINISH);
+	}
+
+	m_WriterStop = true;
+	sphore_signal(&m_WriterSem);
+	thread_wait(m_pWriterThread);
+	m_pWriterThread = nullptr;
+	sphore_destroy(&m_WriterSem);
+
+	io_close(m_File);
+	m_File = 0;
+}
+
+void CTeeHistorian::WriterThread(void *pUser)
+{
+	CTeeHistorian *pSelf = (CTeeHistorian *)pUser;
+	while(true)
+	{
+		sphore_wait(&pSelf->m_WriterSem);
+		bool Stop = pSelf->m_WriterStop;
+
+		{
+			std::lock_guard<std::mutex> Lock(pSelf->m_BufferLock);
+			std::swap(pSelf->m_vBuffer, pSelf->m_vWriting);
+		}
+		if(!pSelf->m_vWriting.empty())
+		{
+			io_write(pSelf->m_File, pSelf->m_vWriting.data(), pSelf->m_vWriting.size());
+			pSelf->m_vWriting.clear();
+		}
+
+		if(Stop)
+			break;
+	}
+	io_flush(pSelf->m_File);
+}
+
+void CTeeHistorian::Flush()
+{
+	if(m_File)
+		sphore_signal(&m_WriterSem);
+}
+
+void CTeeHistorian::WriteInt(int Value)
+{
+	unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
+	unsigned char *pEnd = CVariableInt::Pack(aBuf, Value, sizeof(aBuf));
+	m_vBuffer.insert(m_vBuffer.end(), aBuf, pEnd);
+}
+
+void CTeeHistorian::WriteRaw(const void *pData, int Size)
+{
+	m_vBuffer.insert(m_vBuffer.end(), (const unsigned char *)pData, (const unsigned char *)pData + Size);
+}
+
+void CTeeHistorian::WriteTick(int Tick)
+{
+	if(Tick == m_LastTick)
+		return;
+
+	WriteInt(RECORD_TICK);
+	WriteInt(Tick - m_LastTick);
+	m_LastTick = Tick;
+}
+
+void CTeeHistorian::RecordJoin(int Tick, int ClientID, bool Sixup, bool NoAuth)
+{
+	if(!m_File)
+		return;
+
+	std::lock_guard<std::mutex> Lock(m_BufferLock);
+	WriteTick(Tick);
+	WriteInt(RECORD_JOIN);
+	WriteInt(ClientID);
+
+	unsigned char aData[CVariableInt::MAX_BYTES_PACKED * 2];
+	unsigned char *pEnd = CVariableInt::Pack(aData, ClientID, sizeof(aData));
+	pEnd = CVariableInt::Pack(pEnd, NoAuth, aData + sizeof(aData) - pEnd);
+	CUuid Uuid = g_UuidManager.GetUuid(Sixup ? TEEHISTORIAN_JOINVER7 : TEEHISTORIAN_JOINVER6);
+	WriteInt(RECORD_EX);
+	WriteRaw(&Uuid, sizeof(Uuid));
+	WriteInt(pEnd - aData);
+	WriteRaw(aData, pEnd - aData);
+}
+
+void CTeeHistorian::RecordDrop(int Tick, int ClientID, const char *pReason)
+{
+	if(!m_File)
+		return;
+
+	std::lock_guard<std::mutex> Lock(m_BufferLock);
+	WriteTick(Tick);
+	WriteInt(RECORD_DROP);
+	WriteInt(ClientID);
+	WriteRaw(pReason, str_length(pReason) + 1);
+}
+
+void CTeeHistorian::RecordMessage(int Tick, int ClientID, int Flags, const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+
+	std::lock_guard<std::mutex> Lock(m_BufferLock);
+	WriteTick(Tick);
+	WriteInt(RECORD_MESSAGE);
+	WriteInt(ClientID);
+	WriteInt(Flags);
+	WriteInt(Size);
+	WriteRaw(pData, Size);
+}
+
+void CTeeHistorian::RecordEx(int Tick, int ExID, const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+
+	std::lock_guard<std::mutex> Lock(m_BufferLock);
+	WriteTick(Tick);
+	CUuid Uuid = g_UuidManager.GetUuid(ExID);
+	WriteInt(RECORD_EX);
+	WriteRaw(&Uuid, sizeof(Uuid));
+	WriteInt(Size);
+	WriteRaw(pData, Size);
+}
+
+void CTeeHistorian::RecordSeed(int Tick, int ExID, uint64_t Seed)
+{
+	unsigned char aData[sizeof(Seed)];
+	for(unsigned i = 0; i < sizeof(Seed); i++)
+		aData[i] = (Seed >> (i * 8)) & 0xff;
+	RecordEx(Tick, ExID, aData, sizeof(aData));
+}
+
+CTeeHistorianReader::CTeeHistorianReader() :
+	m_Start(0),
+	m_Pos(0),
+	m_Tick(0)
+{
+}
+
+bool CTeeHistorianReader::Open(IStorage *pStorage, const char *pFilename)
+{
+	m_vData.clear();
+
+	void *pData;
+	unsigned Size;
+	if(!pStorage->ReadFile(pFilename, IStorage::TYPE_ALL, &pData, &Size))
+		return false;
+	m_vData.assign((unsigned char *)pData, (unsigned char *)pData + Size);
+	free(pData);
+
+	if(m_vData.size() < sizeof(CUuid) || mem_comp(m_vData.data(), &CTeeHistorian::ms_Magic, sizeof(CUuid)) != 0)
+	{
+		m_vData.clear();
+		return false;
+	}
+
+	const unsigned char *pEnd = (const unsigned char *)memchr(m_vData.data() + sizeof(CUuid), 0, m_vData.size() - sizeof(CUuid));
+	if(!pEnd)
+	{
+		m_vData.clear();
+		return false;
+	}
+
+	m_Start = pEnd + 1 - m_vData.data();
+	Rewind();
+	return true;
+}
+
+void CTeeHistorianReader::Rewind()
+{
+	m_Pos = m_Start;
+	m_Tick = 0;
+}
+
+bool CTeeHistorianReader::ReadInt(int *pValue)
+{
+	const unsigned char *pNext = CVariableInt::Unpack(m_vData.data() + m_Pos, pValue, m_vData.size() - m_Pos);
+	if(!pNext)
+		return false;
+	m_Pos = pNext - m_vData.data();
+	return true;
+}
+
+const unsigned char *CTeeHistorianReader::ReadRaw(int Size)
+{
+	if(Size < 0 || m_Pos + Size > (int)m_vData.size())
+		return nullptr;
+	const unsigned char *pData = m_vData.data() + m_Pos;
+	m_Pos += Size;
+	return pData;
+}
+
+bool CTeeHistorianReader::Next(CRecord *pRecord)
+{
+	while(true)
+	{
+		int Type;
+		if(!ReadInt(&Type))
+			return false;
+
+		pRecord->m_Type = Type;
+		pRecord->m_ClientID = -1;
+		pRecord->m_Flags = 0;
+		pRecord->m_ExID = UUID_UNKNOWN;
+		pRecord->m_pData = nullptr;
+		pRecord->m_Size = 0;
+
+		switch(Type)
+		{
+		case CTeeHistorian::RECORD_FINISH:
+			return false;
+
+		case CTeeHistorian::RECORD_TICK:
+		{
+			int Delta;
+			if(!ReadInt(&Delta))
+				return false;
+			m_Tick += Delta;
+			continue;
+		}
+
+		case CTeeHistorian::RECORD_JOIN:
+			pRecord->m_Tick = m_Tick;
+			return ReadInt(&pRecord->m_ClientID);
+
+		case CTeeHistorian::RECORD_DROP:
+		{
+			pRecord->m_Tick = m_Tick;
+			if(!ReadInt(&pRecord->m_ClientID))
+				return false;
+			const unsigned char *pEnd = (const unsigned char *)memchr(m_vData.data() + m_Pos, 0, m_vData.size() - m_Pos);
+			if(!pEnd)
+				return false;
+			pRecord->m_pData = m_vData.data() + m_Pos;
+			pRecord->m_Size = pEnd - pRecord->m_pData;
+			m_Pos = pEnd + 1 - m_vData.data();
+			return true;
+		}
+
+		case CTeeHistorian::RECORD_MESSAGE:
+			pRecord->m_Tick = m_Tick;
+			if(!ReadInt(&pRecord->m_ClientID) || !ReadInt(&pRecord->m_Flags) || !ReadInt(&pRecord->m_Size))
+				return false;
+			pRecord->m_pData = ReadRaw(pRecord->m_Size);
+			return pRecord->m_pData != nullptr;
+
+		case CTeeHistorian::RECORD_EX:
+		{
+			pRecord->m_Tick = m_Tick;
+			const unsigned char *pUuid = ReadRaw(sizeof(CUuid));
+			if(!pUuid || !ReadInt(&pRecord->m_Size))
+				return false;
+			CUuid Uuid;
+			mem_copy(&Uuid, pUuid, sizeof(Uuid));
+			pRecord->m_ExID = g_UuidManager.LookupUuid(Uuid);
+			pRecord->m_pData = ReadRaw(pRecord->m_Size);
+			return pRecord->m_pData != nullptr;
+		}
+
+		default:
+			// unknown record without a size, nothing after it can be read
+			return false;
+		}
+	}
+}
+
+void CTeeHistorianReader::Seeds(int ExID, std::vector<uint64_t> *pvSeeds)
+{
+	int Pos = m_Pos;
+	int Tick = m_Tick;
+	Rewind();
+
+	pvSeeds->clear();
+	CRecord Record;
+	while(Next(&Record))
+	{
+		if(Record.m_Type != CTeeHistorian::RECORD_EX || Record.m_ExID != ExID || Record.m_Size != sizeof(uint64_t))
+			continue;
+		uint64_t Seed = 0;
+		for(unsigned i = 0; i < sizeof(Seed); i++)
+			Seed |= (uint64_t)Record.m_pData[i] << (i * 8);
+		pvSeeds->push_back(Seed);
+	}
+
+	m_Pos = Pos;
+	m_Tick = Tick;
+}
+
+int CTeeHistorianReader::FirstTick()
+{
+	int Pos = m_Pos;
+	int Tick = m_Tick;
+	Rewind();
+
+	CRecord Record;
+	int FirstTick = Next(&Record) ? Record.m_Tick : 0;
+
+	m_Pos = Pos;
+	m_Tick = Tick;
+	return FirstTick;
+}
@@ -0,0 +1,128 @@
+#ifndef ENGINE_SERVER_TEEHISTORIAN_H
+#define ENGINE_SERVER_TEEHISTORIAN_H
+
+#include <base/system.h>
+#include <base/uuid.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class IStorage;
+
+/*
+	Class: CTeeHistorian
+		Records what the clients sent to the server, so that a session
+		can be replayed headless to reproduce its tick times: joins,
+		drops, the client packets (inputs, info, game messages) and the
+		seeds of the random generators. Extra data is stored in the
+		uuid chunks of teehistorian_ex_chunks.h.
+
+		The game thread only appends the records to a buffer, a writer
+		thread takes the buffer over and does the file writes.
+
+	File layout:
+		magic uuid, json header ending in a zero byte, then records that
+		start with a negative type, all ints packed as CVariableInt.
+
+		TICK      tick delta to the previous record
+		JOIN      client id
+		DROP      client id, reason
+		MESSAGE   client id, chunk flags, size, raw packet data
+		EX        uuid, size, data
+		FINISH
+*/
+class CTeeHistorian
+{
+public:
+	enum
+	{
+		RECORD_FINISH = -1,
+		RECORD_TICK = -3,
+		RECORD_MESSAGE = -7,
+		RECORD_JOIN = -9,
+		RECORD_DROP = -10,
+		RECORD_EX = -12,
+	};
+
+	static const CUuid ms_Magic;
+
+	CTeeHistorian();
+	~CTeeHistorian();
+
+	bool Start(IStorage *pStorage, const char *pFilename, const char *pGameType, const char *pNetVersion);
+	void Stop();
+	bool IsRecording() const { return m_File != 0; }
+
+	// Tick is the last tick the server ran when the event happened
+	// the joinver ex chunk after the join holds the client id and NoAuth
+	void RecordJoin(int Tick, int ClientID, bool Sixup, bool NoAuth);
+	void RecordDrop(int Tick, int ClientID, const char *pReason);
+	void RecordMessage(int Tick, int ClientID, int Flags, const void *pData, int Size);
+	void RecordEx(int Tick, int ExID, const void *pData, int Size);
+	void RecordSeed(int Tick, int ExID, uint64_t Seed);
+
+	void Flush();
+
+private:
+	IOHANDLE m_File;
+	int m_LastTick;
+
+	// m_vBuffer is filled by the game thread, m_vWriting by the writer thread
+	std::mutex m_BufferLock;
+	std::vector<unsigned char> m_vBuffer;
+	std::vector<unsigned char> m_vWriting;
+
+	void *m_pWriterThread;
+	SEMAPHORE m_WriterSem;
+	std::atomic<bool> m_WriterStop;
+
+	static void WriterThread(void *pUser);
+
+	void WriteTick(int Tick);
+	void WriteInt(int Value);
+	void WriteRaw(const void *pData, int Size);
+};
+
+/*
+	Class: CTeeHistorianReader
+		Reads a whole recording into memory and walks its records.
+*/
+class CTeeHistorianReader
+{
+public:
+	struct CRecord
+	{
+		int m_Type;
+		int m_Tick;
+		int m_ClientID;
+		int m_Flags;
+		int m_ExID;
+		const unsigned char *m_pData;
+		int m_Size;
+	};
+
+	CTeeHistorianReader();
+
+	bool Open(IStorage *pStorage, const char *pFilename);
+	const char *Header() const { return m_vData.empty() ? "" : (const char *)m_vData.data() + sizeof(CUuid); }
+
+	// false at the end of the recording or on a broken record
+	bool Next(CRecord *pRecord);
+	void Rewind();
+
+	// the seeds recorded in an ex chunk, in the order they were recorded
+	void Seeds(int ExID, std::vector<uint64_t> *pvSeeds);
+	int FirstTick();
+
+private:
+	std::vector<unsigned char> m_vData;
+	int m_Start;
+	int m_Pos;
+	int m_Tick;
+
+	bool ReadInt(int *pValue);
+	const unsigned char *ReadRaw(int Size);
+};
+
+#endif
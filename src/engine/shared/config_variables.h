@@ -22,6 +22,9 @@ MACRO_CONFIG_INT(SvExternalPort, sv_external_port, 0, 0, 0, CFGFLAG_SERVER, "Ext
 MACRO_CONFIG_INT(SvMaxClients, sv_max_clients, MAX_CLIENTS, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients that are allowed on a server")
 MACRO_CONFIG_INT(SvMaxClientsPerIP, sv_max_clients_per_ip, 4, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients with the same IP that can connect to the server")
 MACRO_CONFIG_INT(SvHighBandwidth, sv_high_bandwidth, 0, 0, 1, CFGFLAG_SERVER, "Use high bandwidth mode. Doubles the bandwidth required for the server. LAN use only")
+MACRO_CONFIG_INT(SvLoadShed, sv_load_shed, 1, 0, 1, CFGFLAG_SERVER, "Shed load step by step while the server can't keep up with the tick rate")
+MACRO_CONFIG_INT(SvLoadShedOverrunTicks, sv_load_shed_overrun_ticks, 25, 1, 1000, CFGFLAG_SERVER, "Overrun ticks in a row before the next load shedding step")
+MACRO_CONFIG_INT(SvLoadShedRecoverTicks, sv_load_shed_recover_ticks, 250, 1, 10000, CFGFLAG_SERVER, "Ticks with slack in a row before a load shedding step is undone")
 MACRO_CONFIG_STR(SvRegister, sv_register, 16, "1", CFGFLAG_SERVER, "Register server with master server for public listing")
 MACRO_CONFIG_STR(SvRconPassword, sv_rcon_password, 32, "", CFGFLAG_SERVER, "Remote console password (full access)")
 MACRO_CONFIG_STR(SvRconModPassword, sv_rcon_mod_password, 32, "", CFGFLAG_SERVER, "Remote console password for moderators (limited access)")
@@ -29,6 +32,10 @@ MACRO_CONFIG_INT(SvRconMaxTries, sv_rcon_max_tries, 30, 0, 100, CFGFLAG_SERVER,
 MACRO_CONFIG_INT(SvRconBantime, sv_rcon_bantime, 5, 0, 1440, CFGFLAG_SERVER, "The time a client gets banned if remote console authentication fails. 0 makes it just use kick")
 MACRO_CONFIG_INT(SvAutoDemoRecord, sv_auto_demo_record, 0, 0, 1, CFGFLAG_SERVER, "Automatically record demos")
 MACRO_CONFIG_INT(SvAutoDemoMax, sv_auto_demo_max, 10, 0, 1000, CFGFLAG_SERVER, "Maximum number of automatically recorded demos (0 = no limit)")
+MACRO_CONFIG_INT(SvDemoAsync, sv_demo_async, 1, 0, 1, CFGFLAG_SERVER, "Compress and write demos on a separate thread")
+MACRO_CONFIG_INT(SvTeeHistorian, sv_teehistorian, 0, 0, 1, CFGFLAG_SERVER, "Record the client inputs and events of the session to teehistorian/ for replays")
+MACRO_CONFIG_STR(SvTeeHistorianReplay, sv_teehistorian_replay, 128, "", CFGFLAG_SERVER, "Replay this teehistorian recording headless and report the tick times instead of running the server")
+MACRO_CONFIG_STR(SvTeeHistorianReport, sv_teehistorian_report, 128, "", CFGFLAG_SERVER, "File to write the per-tick times of a replay to as csv")
 MACRO_CONFIG_INT(SvServerInfoPerSecond, sv_server_info_per_second, 10, 1, 1000, CFGFLAG_SERVER, "Maximum number of complete server info responses that are sent out per second")
 
 MACRO_CONFIG_INT(SvVanillaAntiSpoof, sv_vanilla_antispoof, 1, 0, 1, CFGFLAG_SERVER, "Enable vanilla Antispoof")
@@ -69,6 +76,10 @@ MACRO_CONFIG_INT(SvConnlimit, sv_connlimit, 5, 0, 100, CFGFLAG_SERVER, "Connlimi
 MACRO_CONFIG_INT(SvConnlimitTime, sv_connlimit_time, 20, 0, 1000, CFGFLAG_SERVER, "Connlimit: Time in which IP's connections are counted")
 
 MACRO_CONFIG_INT(SvMapWindow, sv_map_window, 15, 0, 100, CFGFLAG_SERVER, "Map downloading send-ahead window")
+MACRO_CONFIG_INT(SvMapHttpPort, sv_map_http_port, 0, 0, 65535, CFGFLAG_SERVER, "Port of the built-in http map download server (0 = disabled)")
+MACRO_CONFIG_STR(SvMapHttpBindaddr, sv_map_http_bindaddr, 128, "", CFGFLAG_SERVER, "Address to bind the http map download server to")
+MACRO_CONFIG_STR(SvMapHttpUrl, sv_map_http_url, 128, "", CFGFLAG_SERVER, "Public base url of the http map download server, as clients reach it (empty = http://<bindaddr>:<port> for a concrete bindaddr, else no http downloads)")
+MACRO_CONFIG_INT(SvSeamlessTransfer, sv_seamless_transfer, 1, 0, 1, CFGFLAG_SERVER, "Skip the map change when a client moves to a world whose map it already has loaded. Every world has its own map, so this only covers re-entering the same world")
 MACRO_CONFIG_INT(SvFastDownload, sv_fast_download, 1, 0, 1, CFGFLAG_SERVER, "Enables fast download of maps")
 
 MACRO_CONFIG_INT(SvMapUpdateRate, sv_mapupdaterate, 5, 1, 100, CFGFLAG_SERVER, "(Tw32) real id <-> id players map update rate")
@@ -77,6 +88,7 @@ MACRO_CONFIG_INT(DbgCurl, dbg_curl, 0, 0, 1, CFGFLAG_CLIENT | CFGFLAG_SERVER, "D
 MACRO_CONFIG_INT(DbgStress, dbg_stress, 0, 0, 0, CFGFLAG_CLIENT|CFGFLAG_SERVER, "Stress systems")
 MACRO_CONFIG_INT(DbgStressNetwork, dbg_stress_network, 0, 0, 0, CFGFLAG_CLIENT|CFGFLAG_SERVER, "Stress network")
 MACRO_CONFIG_INT(DbgPref, dbg_pref, 0, 0, 1, CFGFLAG_SERVER, "Performance outputs")
+MACRO_CONFIG_INT(DbgProfile, dbg_profile, 0, 0, 1, CFGFLAG_SERVER, "Record per-subsystem tick timings, see 'profile'")
 MACRO_CONFIG_INT(DbgGraphs, dbg_graphs, 0, 0, 1, CFGFLAG_CLIENT, "Performance graphs")
 MACRO_CONFIG_INT(DbgHitch, dbg_hitch, 0, 0, 0, CFGFLAG_SERVER, "Hitch warnings")
 MACRO_CONFIG_STR(DbgStressServer, dbg_stress_server, 32, "localhost", CFGFLAG_CLIENT, "Server to stress")
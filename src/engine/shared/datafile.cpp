@@ -80,7 +80,11 @@ struct CDatafileInfo
 
 struct CDatafile
 {
-	IOHANDLE m_File;
+	// the whole file, mapped or read in one go
+	unsigned char *m_pFileData;
+	unsigned m_FileSize;
+	bool m_Mapped;
+
 	SHA256_DIGEST m_Sha256;
 	unsigned m_Crc;
 	CDatafileInfo m_Info;
@@ -94,51 +98,60 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 {
 	log_trace("datafile", "loading. filename='%s'", pFilename);
 
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
-	if(!File)
+	// the checksums, the items and the data all come from this one view of the file
+	void *pFileData;
+	unsigned FileSize;
+	bool Mapped = pStorage->MapFile(pFilename, StorageType, &pFileData, &FileSize);
+	if(!Mapped && !pStorage->ReadFile(pFilename, StorageType, &pFileData, &FileSize))
 	{
 		dbg_msg("datafile", "could not open '%s'", pFilename);
 		return false;
 	}
 
+	auto FreeFileData = [&]() {
+		if(Mapped)
+			io_unmap(pFileData, FileSize);
+		else
+			free(pFileData);
+	};
+
 	// take the CRC of the file and store it
 	unsigned Crc = 0;
 	SHA256_DIGEST Sha256;
 	{
 		enum
 		{
-			BUFFER_SIZE = 64 * 1024
+			BLOCK_SIZE = 64 * 1024
 		};
 
+		// both in the same pass, block by block, so every block is only read from memory once
 		SHA256_CTX Sha256Ctxt;
 		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[BUFFER_SIZE];
-
-		while(true)
+		const unsigned char *pData = (const unsigned char *)pFileData;
+		for(unsigned Offset = 0; Offset < FileSize; Offset += BLOCK_SIZE)
 		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes == 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+			unsigned Bytes = minimum((unsigned)BLOCK_SIZE, FileSize - Offset);
+			Crc = crc32(Crc, pData + Offset, Bytes);
+			sha256_update(&Sha256Ctxt, pData + Offset, Bytes);
 		}
 		Sha256 = sha256_finish(&Sha256Ctxt);
-
-		io_seek(File, 0, IOSEEK_START);
 	}
 
 	// TODO: change this header
 	CDatafileHeader Header;
-	if(sizeof(Header) != io_read(File, &Header, sizeof(Header)))
+	if(FileSize < sizeof(Header))
 	{
 		dbg_msg("datafile", "couldn't load header");
+		FreeFileData();
 		return false;
 	}
+	mem_copy(&Header, pFileData, sizeof(Header));
 	if(Header.m_aID[0] != 'A' || Header.m_aID[1] != 'T' || Header.m_aID[2] != 'A' || Header.m_aID[3] != 'D')
 	{
 		if(Header.m_aID[0] != 'D' || Header.m_aID[1] != 'A' || Header.m_aID[2] != 'T' || Header.m_aID[3] != 'A')
 		{
 			dbg_msg("datafile", "wrong signature. %x %x %x %x", Header.m_aID[0], Header.m_aID[1], Header.m_aID[2], Header.m_aID[3]);
+			FreeFileData();
 			return false;
 		}
 	}
@@ -149,10 +162,11 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
 		dbg_msg("datafile", "wrong version. version=%x", Header.m_Version);
+		FreeFileData();
 		return false;
 	}
 
-	// read in the rest except the data
+	// the rest except the data
 	unsigned Size = 0;
 	Size += Header.m_NumItemTypes * sizeof(CDatafileItemType);
 	Size += (Header.m_NumItems + Header.m_NumRawData) * sizeof(int);
@@ -160,32 +174,33 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Size += Header.m_NumRawData * sizeof(int); // v4 has uncompressed data sizes as well
 	Size += Header.m_ItemSize;
 
-	unsigned AllocSize = Size;
-	AllocSize += sizeof(CDatafile); // add space for info structure
-	AllocSize += Header.m_NumRawData * sizeof(void *); // add space for data pointers
+	if(Size > FileSize - sizeof(Header))
+	{
+		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, (int)(FileSize - sizeof(Header)));
+		FreeFileData();
+		return false;
+	}
+
+	unsigned AllocSize = sizeof(CDatafile); // info structure
+	AllocSize += Header.m_NumRawData * sizeof(void *); // data pointers
 
 	CDatafile *pTmpDataFile = (CDatafile *)malloc(AllocSize);
+	pTmpDataFile->m_pFileData = (unsigned char *)pFileData;
+	pTmpDataFile->m_FileSize = FileSize;
+	pTmpDataFile->m_Mapped = Mapped;
 	pTmpDataFile->m_Header = Header;
 	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
 	pTmpDataFile->m_ppDataPtrs = (char **)(pTmpDataFile + 1);
-	pTmpDataFile->m_pData = (char *)(pTmpDataFile + 1) + Header.m_NumRawData * sizeof(char *);
-	pTmpDataFile->m_File = File;
+	// the file bytes are served to clients as they are. Types, offsets, sizes and
+	// item data get swapped and users write to items, so they are a copy
+	pTmpDataFile->m_pData = (char *)malloc(Size);
+	mem_copy(pTmpDataFile->m_pData, (char *)pFileData + sizeof(CDatafileHeader), Size);
 	pTmpDataFile->m_Sha256 = Sha256;
 	pTmpDataFile->m_Crc = Crc;
 
 	// clear the data pointers
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
 
-	// read types, offsets, sizes and item data
-	unsigned ReadSize = io_read(File, pTmpDataFile->m_pData, Size);
-	if(ReadSize != Size)
-	{
-		io_close(pTmpDataFile->m_File);
-		free(pTmpDataFile);
-		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
-		return false;
-	}
-
 	Close();
 	m_pDataFile = pTmpDataFile;
 
@@ -196,7 +211,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(DEBUG)
 	{
 		dbg_msg("datafile", "allocsize=%d", AllocSize);
-		dbg_msg("datafile", "readsize=%d", ReadSize);
+		dbg_msg("datafile", "filesize=%d mapped=%d", FileSize, Mapped);
 		dbg_msg("datafile", "swaplen=%d", Header.m_Swaplen);
 		dbg_msg("datafile", "item_size=%d", m_pDataFile->m_Header.m_ItemSize);
 	}
@@ -226,17 +241,28 @@ bool CDataFileReader::Close()
 	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
 		free(m_pDataFile->m_ppDataPtrs[i]);
 
-	io_close(m_pDataFile->m_File);
+	free(m_pDataFile->m_pData);
+	if(m_pDataFile->m_Mapped)
+		io_unmap(m_pDataFile->m_pFileData, m_pDataFile->m_FileSize);
+	else
+		free(m_pDataFile->m_pFileData);
 	free(m_pDataFile);
 	m_pDataFile = nullptr;
 	return true;
 }
 
-IOHANDLE CDataFileReader::File() const
+const unsigned char *CDataFileReader::FileData() const
+{
+	if(!m_pDataFile)
+		return nullptr;
+	return m_pDataFile->m_pFileData;
+}
+
+unsigned CDataFileReader::FileSize() const
 {
 	if(!m_pDataFile)
 		return 0;
-	return m_pDataFile->m_File;
+	return m_pDataFile->m_FileSize;
 }
 
 int CDataFileReader::NumData() const
@@ -294,37 +320,36 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 		int SwapSize = DataSize;
 #endif
 
+		unsigned Offset = m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index];
+		if(DataSize < 0 || Offset > m_pDataFile->m_FileSize || (unsigned)DataSize > m_pDataFile->m_FileSize - Offset)
+		{
+			dbg_msg("datafile", "data index=%d is out of the file", Index);
+			return nullptr;
+		}
+		const unsigned char *pFileData = m_pDataFile->m_pFileData + Offset;
+
 		if(m_pDataFile->m_Header.m_Version == 4)
 		{
 			// v4 has compressed data
-			void *pTemp = malloc(DataSize);
 			unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
 			unsigned long s;
 
 			log_trace("datafile", "loading data index=%d size=%d uncompressed=%lu", Index, DataSize, UncompressedSize);
 			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(UncompressedSize);
 
-			// read the compressed data
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, pTemp, DataSize);
-
-			// decompress the data, TODO: check for errors
+			// decompress the data straight from the file, TODO: check for errors
 			s = UncompressedSize;
-			uncompress((Bytef *)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef *)pTemp, DataSize);
+			uncompress((Bytef *)m_pDataFile->m_ppDataPtrs[Index], &s, (const Bytef *)pFileData, DataSize);
 #if defined(CONF_ARCH_ENDIAN_BIG)
 			SwapSize = s;
 #endif
-
-			// clean up the temporary buffers
-			free(pTemp);
 		}
 		else
 		{
 			// load the data
 			log_trace("datafile", "loading data index=%d size=%d", Index, DataSize);
 			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(DataSize);
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
+			mem_copy(m_pDataFile->m_ppDataPtrs[Index], pFileData, DataSize);
 		}
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
@@ -518,6 +543,9 @@ int CDataFileReader::MapSize() const
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
+	m_pStorage = nullptr;
+	m_StorageType = IStorage::TYPE_SAVE;
+	m_aFilename[0] = 0;
 	m_pItemTypes = static_cast<CItemTypeInfo *>(calloc(MAX_ITEM_TYPES, sizeof(CItemTypeInfo)));
 	m_pItems = static_cast<CItemInfo *>(calloc(MAX_ITEMS, sizeof(CItemInfo)));
 	m_pDatas = static_cast<CDataInfo *>(calloc(MAX_DATAS, sizeof(CDataInfo)));
@@ -540,8 +568,19 @@ CDataFileWriter::~CDataFileWriter()
 bool CDataFileWriter::OpenFile(class IStorage *pStorage, const char *pFilename, int StorageType)
 {
 	dbg_assert(!m_File, "a file already exists");
-	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, StorageType);
-	return m_File != 0;
+
+	// write next to the target and rename it in Finish. A reader may have the
+	// old file mapped, replacing it keeps that mapping intact, truncating it wouldn't
+	char aTempFilename[IO_MAX_PATH_LENGTH];
+	str_format(aTempFilename, sizeof(aTempFilename), "%s.tmp", pFilename);
+	m_File = pStorage->OpenFile(aTempFilename, IOFLAG_WRITE, StorageType);
+	if(!m_File)
+		return false;
+
+	m_pStorage = pStorage;
+	m_StorageType = StorageType < 0 ? (int)IStorage::TYPE_SAVE : StorageType;
+	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
+	return true;
 }
 
 void CDataFileWriter::Init()
@@ -849,6 +888,15 @@ int CDataFileWriter::Finish()
 	io_close(m_File);
 	m_File = 0;
 
+	char aTempFilename[IO_MAX_PATH_LENGTH];
+	str_format(aTempFilename, sizeof(aTempFilename), "%s.tmp", m_aFilename);
+	if(!m_pStorage->RenameFile(aTempFilename, m_aFilename, m_StorageType))
+	{
+		dbg_msg("datafile", "couldn't replace '%s'", m_aFilename);
+		m_pStorage->RemoveFile(aTempFilename, m_StorageType);
+		return 1;
+	}
+
 	if(DEBUG)
 		dbg_msg("datafile", "done");
 	return 0;
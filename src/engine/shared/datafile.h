@@ -33,7 +33,9 @@ public:
 	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
 	bool Close();
 	bool IsOpen() const { return m_pDataFile != nullptr; }
-	IOHANDLE File() const;
+	// the whole file as it is on disk
+	const unsigned char *FileData() const;
+	unsigned FileSize() const;
 
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
@@ -89,6 +91,9 @@ class CDataFileWriter
 	};
 
 	IOHANDLE m_File;
+	class IStorage *m_pStorage;
+	int m_StorageType;
+	char m_aFilename[IO_MAX_PATH_LENGTH];
 	int m_NumItems;
 	int m_NumDatas;
 	int m_NumItemTypes;
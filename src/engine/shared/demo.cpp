@@ -24,10 +24,13 @@ CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta)
 	m_File = 0;
 	m_LastTickMarker = -1;
 	m_pSnapshotDelta = pSnapshotDelta;
+	m_Async = false;
+	m_pWriterThread = 0;
+	m_pRing = 0;
 }
 
 // Record
-int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, unsigned Crc, const char *pType)
+int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, unsigned Crc, const char *pType, bool Async)
 {
 	CDemoHeader Header;
 	CTimelineMarkers TimelineMarkers;
@@ -76,6 +79,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 
 	// write header
 	mem_zero(&Header, sizeof(Header));
+	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
 	mem_copy(Header.m_aMarker, gs_aHeaderMarker, sizeof(Header.m_aMarker));
 	Header.m_Version = gs_ActVersion;
 	str_copy(Header.m_aNetversion, pNetVersion, sizeof(Header.m_aNetversion));
@@ -116,6 +120,17 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
 	m_File = DemoFile;
 
+	m_Async = Async;
+	if(m_Async)
+	{
+		m_pRing = (unsigned char *)malloc(WRITE_RING_SIZE);
+		m_RingRead.store(0);
+		m_RingWrite.store(0);
+		m_WriterStop.store(false);
+		sphore_init(&m_WriterSem);
+		m_pWriterThread = thread_init(WriterThread, this, "demo writer");
+	}
+
 	return 0;
 }
 
@@ -144,6 +159,11 @@ enum
 	CHUNKTYPE_MESSAGE = 2,
 	CHUNKTYPE_DELTA = 3,
 
+	// recorder internal, bytes written as they are
+	CHUNKTYPE_RAW = 0,
+	// recorder internal, the rest of the write ring is unused
+	CHUNKTYPE_WRAP = -1,
+
 	CHUNKFLAG_BIGSIZE = 0x10
 };
 
@@ -161,13 +181,13 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 		if(Keyframe)
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
 
-		io_write(m_File, aChunk, sizeof(aChunk));
+		Write(CHUNKTYPE_RAW, aChunk, sizeof(aChunk));
 	}
 	else
 	{
 		unsigned char aChunk[1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | (Tick-m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		Write(CHUNKTYPE_RAW, aChunk, sizeof(aChunk));
 	}
 
 	m_LastTickMarker = Tick;
@@ -176,13 +196,87 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 }
 
 void CDemoRecorder::Write(int Type, const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+
+	if(m_Async)
+		Queue(Type, pData, Size);
+	else
+		WriteChunk(Type, pData, Size);
+}
+
+void CDemoRecorder::Queue(int Type, const void *pData, int Size)
+{
+	// records are 8 byte aligned, so there is always room for a wrap record
+	unsigned Need = (sizeof(CRingRecord) + Size + 7) & ~7u;
+	unsigned Write = m_RingWrite.load(std::memory_order_relaxed);
+	unsigned Pos = Write % WRITE_RING_SIZE;
+	unsigned Skip = WRITE_RING_SIZE - Pos < Need ? WRITE_RING_SIZE - Pos : 0;
+
+	// wait for the writer, dropping a chunk would break the demo
+	while(Write + Skip + Need - m_RingRead.load(std::memory_order_acquire) > WRITE_RING_SIZE)
+		thread_yield();
+
+	if(Skip)
+	{
+		CRingRecord *pWrap = (CRingRecord *)(m_pRing + Pos);
+		pWrap->m_Type = CHUNKTYPE_WRAP;
+		pWrap->m_Size = 0;
+		Write += Skip;
+		Pos = 0;
+	}
+
+	CRingRecord *pRecord = (CRingRecord *)(m_pRing + Pos);
+	pRecord->m_Type = Type;
+	pRecord->m_Size = Size;
+	mem_copy(pRecord + 1, pData, Size);
+	m_RingWrite.store(Write + Need, std::memory_order_release);
+	sphore_signal(&m_WriterSem);
+}
+
+void CDemoRecorder::WriterThread(void *pUser)
+{
+	CDemoRecorder *pSelf = (CDemoRecorder *)pUser;
+
+	while(true)
+	{
+		sphore_wait(&pSelf->m_WriterSem);
+
+		// stop is only set after the last chunk was queued
+		bool Stop = pSelf->m_WriterStop.load();
+		unsigned Read = pSelf->m_RingRead.load(std::memory_order_relaxed);
+		unsigned Write = pSelf->m_RingWrite.load(std::memory_order_acquire);
+		while(Read != Write)
+		{
+			unsigned Pos = Read % WRITE_RING_SIZE;
+			const CRingRecord *pRecord = (const CRingRecord *)(pSelf->m_pRing + Pos);
+			if(pRecord->m_Type == CHUNKTYPE_WRAP)
+				Read += WRITE_RING_SIZE - Pos;
+			else
+			{
+				pSelf->WriteChunk(pRecord->m_Type, pRecord + 1, pRecord->m_Size);
+				Read += (sizeof(CRingRecord) + pRecord->m_Size + 7) & ~7u;
+			}
+			pSelf->m_RingRead.store(Read, std::memory_order_release);
+		}
+
+		if(Stop)
+			break;
+	}
+}
+
+void CDemoRecorder::WriteChunk(int Type, const void *pData, int Size)
 {
 	char aBuffer[64*1024];
 	char aBuffer2[64*1024];
 	unsigned char aChunk[3];
 
-	if(!m_File)
+	if(Type == CHUNKTYPE_RAW)
+	{
+		io_write(m_File, pData, Size);
 		return;
+	}
 
 	/* pad the data with 0 so we get an alignment of 4,
 	else the compression won't work and miss some bytes */
@@ -263,6 +357,19 @@ int CDemoRecorder::Stop()
 	if(!m_File)
 		return -1;
 
+	// let the writer finish the queued chunks before the header is patched
+	if(m_Async)
+	{
+		m_WriterStop.store(true);
+		sphore_signal(&m_WriterSem);
+		thread_wait(m_pWriterThread);
+		m_pWriterThread = 0;
+		sphore_destroy(&m_WriterSem);
+		free(m_pRing);
+		m_pRing = 0;
+		m_Async = false;
+	}
+
 	// add the demo length to the header
 	io_seek(m_File, gs_LengthOffset, IOSEEK_START);
 	int DemoLength = Length();
@@ -8,6 +8,8 @@
 
 #include "snapshot.h"
 
+#include <atomic>
+
 class CDemoRecorder : public IDemoRecorder
 {
 	class IConsole *m_pConsole;
@@ -20,12 +22,40 @@ class CDemoRecorder : public IDemoRecorder
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
 
+	// asynchronous writing: the tick thread still decides the tickmarkers,
+	// keyframes and deltas, but the compression and the file writes of the
+	// chunks happen on a writer thread. The chunks are handed over through
+	// a bounded single producer single consumer byte ring, the tick thread
+	// waits when it's full so that nothing is ever dropped.
+	enum
+	{
+		WRITE_RING_SIZE = 1024 * 1024,
+	};
+
+	struct CRingRecord
+	{
+		int m_Type;
+		int m_Size;
+	};
+
+	bool m_Async;
+	void *m_pWriterThread;
+	SEMAPHORE m_WriterSem;
+	std::atomic<bool> m_WriterStop;
+	unsigned char *m_pRing;
+	std::atomic<unsigned> m_RingRead;
+	std::atomic<unsigned> m_RingWrite;
+
+	static void WriterThread(void *pUser);
+	void Queue(int Type, const void *pData, int Size);
+
 	void WriteTickMarker(int Tick, int Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void WriteChunk(int Type, const void *pData, int Size);
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta);
 
-	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, const char *pType);
+	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, const char *pType, bool Async);
 	int Stop();
 	void AddDemoMarker();
 
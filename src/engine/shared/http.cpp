@@ -234,6 +234,8 @@ int CHttpRequest::RunImpl(CURL *pUser)
 
 	curl_easy_setopt(pHandle, CURLOPT_WRITEDATA, this);
 	curl_easy_setopt(pHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+	curl_easy_setopt(pHandle, CURLOPT_HEADERDATA, this);
+	curl_easy_setopt(pHandle, CURLOPT_HEADERFUNCTION, HeaderCallback);
 	curl_easy_setopt(pHandle, CURLOPT_NOPROGRESS, 0L);
 	curl_easy_setopt(pHandle, CURLOPT_PROGRESSDATA, this);
 	// ‘CURLOPT_PROGRESSFUNCTION’ is deprecated: since 7.32.0. Use CURLOPT_XFERINFOFUNCTION
@@ -287,6 +289,7 @@ int CHttpRequest::RunImpl(CURL *pUser)
 		dbg_msg("http", "fetching %s", m_aUrl);
 	m_State = HTTP_RUNNING;
 	int Ret = curl_easy_perform(pHandle);
+	curl_easy_getinfo(pHandle, CURLINFO_RESPONSE_CODE, &m_StatusCode);
 	if(Ret != CURLE_OK)
 	{
 		if(g_Config.m_DbgCurl || m_LogProgress >= HTTPLOG::FAILURE)
@@ -344,6 +347,40 @@ size_t CHttpRequest::WriteCallback(char *pData, size_t Size, size_t Number, void
 	return ((CHttpRequest *)pUser)->OnData(pData, Size * Number);
 }
 
+size_t CHttpRequest::HeaderCallback(char *pData, size_t Size, size_t Number, void *pUser)
+{
+	CHttpRequest *pTask = (CHttpRequest *)pUser;
+	// a status line starts the headers of the next response after a redirect
+	if(Size * Number >= 5 && mem_comp(pData, "HTTP/", 5) == 0)
+		pTask->m_ResponseHeaders.clear();
+	pTask->m_ResponseHeaders.append(pData, Size * Number);
+	return Size * Number;
+}
+
+bool CHttpRequest::ResponseHeader(const char *pName, char *pBuf, int BufSize) const
+{
+	const char *pLine = m_ResponseHeaders.c_str();
+	while(*pLine)
+	{
+		const char *pEnd = str_find(pLine, "\n");
+		int Length = pEnd ? pEnd - pLine : str_length(pLine);
+
+		const char *pValue = str_startswith_nocase(pLine, pName);
+		if(pValue && pValue - pLine < Length && *pValue == ':')
+		{
+			pValue = str_skip_whitespaces_const(pValue + 1);
+			str_truncate(pBuf, BufSize, pValue, pLine + Length - pValue);
+			str_utf8_trim_right(pBuf);
+			return true;
+		}
+
+		if(!pEnd)
+			break;
+		pLine = pEnd + 1;
+	}
+	return false;
+}
+
 int CHttpRequest::ProgressCallback(void *pUser, double DlTotal, double DlCurr, double UlTotal, double UlCurr)
 {
 	CHttpRequest *pTask = (CHttpRequest *)pUser;
@@ -359,9 +396,12 @@ int CHttpRequest::OnCompletion(int State)
 	if(m_Abort)
 		State = HTTP_ABORTED;
 
+	if(State == HTTP_DONE)
+		m_ResultSha256 = sha256_finish(&m_ActualSha256);
+
 	if(State == HTTP_DONE && m_ExpectedSha256 != SHA256_ZEROED)
 	{
-		const SHA256_DIGEST ActualSha256 = sha256_finish(&m_ActualSha256);
+		const SHA256_DIGEST ActualSha256 = m_ResultSha256;
 		if(ActualSha256 != m_ExpectedSha256)
 		{
 			if(g_Config.m_DbgCurl || m_LogProgress >= HTTPLOG::FAILURE)
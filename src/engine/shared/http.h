@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <string>
 
 #include <engine/external/json/json.hpp>
 
@@ -64,6 +65,11 @@ class CHttpRequest : public IJob
 
 	SHA256_CTX m_ActualSha256;
 	SHA256_DIGEST m_ExpectedSha256 = SHA256_ZEROED;
+	SHA256_DIGEST m_ResultSha256 = SHA256_ZEROED;
+
+	// of the last response, earlier ones are redirects
+	long m_StatusCode = 0;
+	std::string m_ResponseHeaders;
 
 	bool m_WriteToFile = false;
 
@@ -98,6 +104,7 @@ class CHttpRequest : public IJob
 
 	static int ProgressCallback(void *pUser, double DlTotal, double DlCurr, double UlTotal, double UlCurr);
 	static size_t WriteCallback(char *pData, size_t Size, size_t Number, void *pUser);
+	static size_t HeaderCallback(char *pData, size_t Size, size_t Number, void *pUser);
 
 protected:
 	virtual void OnProgress() {}
@@ -177,6 +184,12 @@ public:
 	int State() const { return m_State; }
 	void Abort() { m_Abort = true; }
 
+	// valid once the request is done
+	long StatusCode() const { return m_StatusCode; }
+	const SHA256_DIGEST &ResultSha256() const { return m_ResultSha256; }
+	// value of a response header, false if the response didn't have it
+	bool ResponseHeader(const char *pName, char *pBuf, int BufSize) const;
+
 	void Result(unsigned char **ppResult, size_t *pResultLength) const;
 	nlohmann::json ResultJson();
 };
@@ -68,4 +68,14 @@ SHA256_DIGEST CMap::Sha256()
 	return m_DataFile.Sha256();
 }
 
+const unsigned char *CMap::FileData()
+{
+	return m_DataFile.FileData();
+}
+
+unsigned CMap::FileSize()
+{
+	return m_DataFile.FileSize();
+}
+
 extern IEngineMap *CreateEngineMap() { return new CMap; }
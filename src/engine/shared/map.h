@@ -6,6 +6,8 @@
 #include <engine/storage.h>
 #include "datafile.h"
 
+#include <vector>
+
 class CMap : public IEngineMap
 {
 	CDataFileReader m_DataFile;
@@ -27,6 +29,8 @@ public:
 
 	unsigned Crc() override;
 	SHA256_DIGEST Sha256() override;
+	const unsigned char *FileData() override;
+	unsigned FileSize() override;
 };
 
 struct CMapData
@@ -36,8 +40,16 @@ struct CMapData
     char m_aMap[64];
     SHA256_DIGEST m_MapSha256;
     unsigned m_MapCrc;
-    unsigned char *m_pMapData;
+    // points into the loaded map, owned by m_pMap
+    const unsigned char *m_pMapData;
     unsigned int m_MapSize;
+
+    // the NETMSG_MAP_DATA messages of all chunks, packed once when the map
+    // is loaded. Each index is a full copy of the map with the message headers.
+    // Index 0 holds the 0.6 ones, index 1 the 0.7 ones, chunk i
+    // is m_aChunkData[i] from m_aChunkOffsets[i] to m_aChunkOffsets[i + 1]
+    std::vector<unsigned char> m_aChunkData[2];
+    std::vector<unsigned> m_aChunkOffsets[2];
 };
 
 #endif
\ No newline at end of file
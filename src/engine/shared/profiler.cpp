@@ -0,0 +1,209 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include "profiler.h"
+
+#include <base/math.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static const char *s_apZoneNames[NUM_PROFILE_ZONES] = {
+	"tick",
+	"gameworld_tick",
+	"bot_ai",
+	"bot_think",
+	"update_player_maps",
+	"data_tick",
+	"snapshot",
+	"snap_build",
+	"snap_delta",
+	"snap_compress",
+	"pump_network",
+};
+
+namespace {
+
+struct CEvent
+{
+	int m_Zone;
+	int64_t m_Start;
+	int64_t m_End;
+};
+
+// single producer (the owning thread), single consumer (Collect)
+class CThreadBuffer
+{
+public:
+	enum
+	{
+		SIZE = 4096,
+	};
+
+	CEvent m_aEvents[SIZE];
+	std::atomic<unsigned> m_Write{0};
+	std::atomic<unsigned> m_Read{0};
+	std::atomic<unsigned> m_Dropped{0};
+	int m_ThreadIndex;
+};
+
+struct CZoneWindow
+{
+	int64_t m_aSamples[CProfiler::WINDOW_SIZE];
+	int m_NumSamples;
+	int m_Next;
+	int64_t m_Count;
+};
+
+std::mutex s_BufferLock;
+std::vector<std::unique_ptr<CThreadBuffer>> s_vpBuffers;
+thread_local CThreadBuffer *t_pBuffer = nullptr;
+
+// only touched by the thread calling Collect
+CZoneWindow s_aWindows[NUM_PROFILE_ZONES];
+IOHANDLE s_TraceFile = nullptr;
+int64_t s_TraceStart = 0;
+bool s_TraceFirst = true;
+
+CThreadBuffer *ThreadBuffer()
+{
+	if(!t_pBuffer)
+	{
+		std::unique_ptr<CThreadBuffer> pBuffer = std::make_unique<CThreadBuffer>();
+		std::lock_guard<std::mutex> Lock(s_BufferLock);
+		pBuffer->m_ThreadIndex = (int)s_vpBuffers.size();
+		t_pBuffer = pBuffer.get();
+		s_vpBuffers.push_back(std::move(pBuffer));
+	}
+	return t_pBuffer;
+}
+
+void WriteTraceEvent(int ThreadIndex, const CEvent *pEvent)
+{
+	if(pEvent->m_Start < s_TraceStart)
+		return;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+		s_TraceFirst ? "" : ",\n", s_apZoneNames[pEvent->m_Zone], ThreadIndex,
+		(long long)((pEvent->m_Start - s_TraceStart) * 1000000 / time_freq()),
+		(long long)((pEvent->m_End - pEvent->m_Start) * 1000000 / time_freq()));
+	io_write(s_TraceFile, aBuf, str_length(aBuf));
+	s_TraceFirst = false;
+}
+
+}
+
+std::atomic<bool> CProfiler::ms_Enabled{false};
+
+void CProfiler::SetEnabled(bool Enabled)
+{
+	ms_Enabled.store(Enabled, std::memory_order_relaxed);
+}
+
+const char *CProfiler::ZoneName(int Zone)
+{
+	if(Zone < 0 || Zone >= NUM_PROFILE_ZONES)
+		return "unknown";
+	return s_apZoneNames[Zone];
+}
+
+void CProfiler::Record(int Zone, int64_t Start, int64_t End)
+{
+	CThreadBuffer *pBuffer = ThreadBuffer();
+
+	unsigned Write = pBuffer->m_Write.load(std::memory_order_relaxed);
+	if(Write - pBuffer->m_Read.load(std::memory_order_acquire) >= CThreadBuffer::SIZE)
+	{
+		pBuffer->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	CEvent *pEvent = &pBuffer->m_aEvents[Write % CThreadBuffer::SIZE];
+	pEvent->m_Zone = Zone;
+	pEvent->m_Start = Start;
+	pEvent->m_End = End;
+	pBuffer->m_Write.store(Write + 1, std::memory_order_release);
+}
+
+void CProfiler::Collect()
+{
+	std::lock_guard<std::mutex> Lock(s_BufferLock);
+	for(auto &pBuffer : s_vpBuffers)
+	{
+		unsigned Read = pBuffer->m_Read.load(std::memory_order_relaxed);
+		unsigned Write = pBuffer->m_Write.load(std::memory_order_acquire);
+		for(; Read != Write; Read++)
+		{
+			const CEvent *pEvent = &pBuffer->m_aEvents[Read % CThreadBuffer::SIZE];
+
+			CZoneWindow *pWindow = &s_aWindows[pEvent->m_Zone];
+			pWindow->m_aSamples[pWindow->m_Next] = pEvent->m_End - pEvent->m_Start;
+			pWindow->m_Next = (pWindow->m_Next + 1) % WINDOW_SIZE;
+			pWindow->m_NumSamples = minimum(pWindow->m_NumSamples + 1, (int)WINDOW_SIZE);
+			pWindow->m_Count++;
+
+			if(s_TraceFile)
+				WriteTraceEvent(pBuffer->m_ThreadIndex, pEvent);
+		}
+		pBuffer->m_Read.store(Read, std::memory_order_release);
+	}
+}
+
+void CProfiler::Reset()
+{
+	Collect();
+	mem_zero(s_aWindows, sizeof(s_aWindows));
+}
+
+void CProfiler::GetStats(int Zone, CZoneStats *pStats)
+{
+	mem_zero(pStats, sizeof(*pStats));
+	if(Zone < 0 || Zone >= NUM_PROFILE_ZONES)
+		return;
+
+	const CZoneWindow *pWindow = &s_aWindows[Zone];
+	pStats->m_NumSamples = pWindow->m_NumSamples;
+	pStats->m_Count = pWindow->m_Count;
+	if(!pWindow->m_NumSamples)
+		return;
+
+	std::vector<int64_t> vSorted(pWindow->m_aSamples, pWindow->m_aSamples + pWindow->m_NumSamples);
+	std::sort(vSorted.begin(), vSorted.end());
+	pStats->m_P50 = vSorted[(vSorted.size() - 1) / 2];
+	pStats->m_P99 = vSorted[(vSorted.size() - 1) * 99 / 100];
+	pStats->m_Max = vSorted.back();
+}
+
+bool CProfiler::StartTrace(IOHANDLE File)
+{
+	if(!File)
+		return false;
+
+	StopTrace();
+	// don't put the events recorded before the trace started into it
+	Collect();
+
+	s_TraceFile = File;
+	s_TraceStart = time_get();
+	s_TraceFirst = true;
+	io_write(s_TraceFile, "[\n", 2);
+	return true;
+}
+
+void CProfiler::StopTrace()
+{
+	if(!s_TraceFile)
+		return;
+
+	Collect();
+	io_write(s_TraceFile, "\n]\n", 3);
+	io_close(s_TraceFile);
+	s_TraceFile = nullptr;
+}
+
+bool CProfiler::Tracing()
+{
+	return s_TraceFile != nullptr;
+}
@@ -0,0 +1,98 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+
+#include <atomic>
+
+enum
+{
+	PROFILE_TICK = 0,
+	PROFILE_GAMEWORLD_TICK,
+	PROFILE_BOT_AI,
+	PROFILE_BOT_THINK,
+	PROFILE_UPDATE_PLAYER_MAPS,
+	PROFILE_DATA_TICK,
+	PROFILE_SNAPSHOT,
+	PROFILE_SNAP_BUILD,
+	PROFILE_SNAP_DELTA,
+	PROFILE_SNAP_COMPRESS,
+	PROFILE_PUMP_NETWORK,
+	NUM_PROFILE_ZONES
+};
+
+/*
+	Class: CProfiler
+		Scoped timers for the server loop. Every thread records into its
+		own ring buffer, the game thread drains them once per loop in
+		Collect and keeps the last samples of each zone for the stats.
+		When disabled a zone costs a single relaxed atomic load.
+*/
+class CProfiler
+{
+	static std::atomic<bool> ms_Enabled;
+
+public:
+	enum
+	{
+		WINDOW_SIZE = 1024,
+	};
+
+	struct CZoneStats
+	{
+		int m_NumSamples;
+		int64_t m_Count;
+		int64_t m_P50;
+		int64_t m_P99;
+		int64_t m_Max;
+	};
+
+	static bool Enabled() { return ms_Enabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool Enabled);
+
+	static const char *ZoneName(int Zone);
+
+	static void Record(int Zone, int64_t Start, int64_t End);
+	static void Collect();
+	static void Reset();
+
+	// times are in time_get() units
+	static void GetStats(int Zone, CZoneStats *pStats);
+
+	// writes chrome://tracing compatible trace events until StopTrace
+	static bool StartTrace(IOHANDLE File);
+	static void StopTrace();
+	static bool Tracing();
+};
+
+class CProfileScope
+{
+	int m_Zone;
+	int64_t m_Start;
+
+public:
+	CProfileScope(int Zone)
+	{
+		if(CProfiler::Enabled())
+		{
+			m_Zone = Zone;
+			m_Start = time_get();
+		}
+		else
+			m_Zone = -1;
+	}
+
+	~CProfileScope()
+	{
+		if(m_Zone >= 0)
+			CProfiler::Record(m_Zone, m_Start, time_get());
+	}
+};
+
+#define PROFILE_SCOPE_NAME2(Line) ProfileScope##Line
+#define PROFILE_SCOPE_NAME(Line) PROFILE_SCOPE_NAME2(Line)
+#define PROFILE_SCOPE(Zone) CProfileScope PROFILE_SCOPE_NAME(__LINE__)(Zone)
+
+#endif
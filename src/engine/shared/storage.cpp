@@ -421,6 +421,20 @@ public:
 		io_close(File);
 		return true;
 	}
+
+	bool MapFile(const char *pFilename, int Type, void **ppResult, unsigned *pResultLen) override
+	{
+		IOHANDLE File = OpenFile(pFilename, IOFLAG_READ, Type);
+		if(!File)
+		{
+			*ppResult = nullptr;
+			*pResultLen = 0;
+			return false;
+		}
+		bool Result = io_map(File, ppResult, pResultLen) == 0;
+		io_close(File);
+		return Result;
+	}
 };
 
 IStorage *CreateStorage(const char *pApplicationName, int StorageType, int NumArgs, const char **ppArguments) { return CStorage::Create(pApplicationName, StorageType, NumArgs, ppArguments); }
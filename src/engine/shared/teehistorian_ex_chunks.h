@@ -16,3 +16,6 @@ UUID(TEEHISTORIAN_LOAD_FAILURE, "teehistorian-load-failure@ddnet.tw")
 UUID(TEEHISTORIAN_PLAYER_TEAM, "teehistorian-player-team@ddnet.tw")
 UUID(TEEHISTORIAN_TEAM_PRACTICE, "teehistorian-team-practice@ddnet.tw")
 UUID(TEEHISTORIAN_PLAYER_READY, "teehistorian-player-ready@ddnet.tw")
+UUID(TEEHISTORIAN_MAP_SEED, "teehistorian-map-seed@lunartee")
+UUID(TEEHISTORIAN_BOT_SEED, "teehistorian-bot-seed@lunartee")
+UUID(TEEHISTORIAN_WORLD_SEED, "teehistorian-world-seed@lunartee")
@@ -27,6 +27,8 @@ public:
 	virtual bool CreateFolder(const char *pFoldername, int Type) = 0;
 	virtual void GetCompletePath(int Type, const char *pDir, char *pBuffer, unsigned BufferSize) = 0;
 	virtual bool ReadFile(const char *pFilename, int Type, void **ppResult, unsigned *pResultLen) = 0;
+	// maps the file copy-on-write, release it with io_unmap
+	virtual bool MapFile(const char *pFilename, int Type, void **ppResult, unsigned *pResultLen) = 0;
 };
 
 extern IStorage *CreateStorage(const char *pApplicationName, int StorageType, int NumArgs, const char **ppArguments);
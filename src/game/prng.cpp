@@ -0,0 +1,45 @@
+#include "prng.h"
+
+// From https://www.pcg-random.org/download.html "Minimal C Implementation"
+
+CPrng::CPrng() :
+	m_State(0),
+	m_Increment(0),
+	m_Seeded(false)
+{
+}
+
+void CPrng::Seed(uint64_t Seed, uint64_t Stream)
+{
+	m_Seeded = true;
+	m_State = 0;
+	m_Increment = (Stream << 1) | 1;
+	RandomBits();
+	m_State += Seed;
+	RandomBits();
+}
+
+unsigned int CPrng::RandomBits()
+{
+	dbg_assert(m_Seeded, "prng needs to be seeded before it can generate random numbers");
+
+	uint64_t OldState = m_State;
+	m_State = OldState * 6364136223846793005ULL + m_Increment;
+	unsigned int XorShifted = ((OldState >> 18u) ^ OldState) >> 27u;
+	unsigned int Rot = OldState >> 59u;
+	return (XorShifted >> Rot) | (XorShifted << ((-Rot) & 31));
+}
+
+int CPrng::RandomInt(int Min, int Max)
+{
+	if(Max <= Min)
+		return Min;
+
+	uint64_t Range = (uint64_t)((int64_t)Max - Min) + 1;
+	return Min + (int)(RandomBits() % Range);
+}
+
+float CPrng::RandomFloat()
+{
+	return (RandomBits() >> 8) / (float)(1 << 24);
+}
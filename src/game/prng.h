@@ -0,0 +1,35 @@
+#ifndef GAME_PRNG_H
+#define GAME_PRNG_H
+
+#include <base/system.h>
+
+// PCG32, small and fast enough to give every seeded game action its own
+// generator. Unlike random_int it produces the same sequence for the same
+// seed on every platform.
+class CPrng
+{
+public:
+	// Creates an unseeded instance.
+	CPrng();
+
+	// Seeds the generator, Stream selects one of 2^63 independent sequences.
+	void Seed(uint64_t Seed, uint64_t Stream = 0);
+
+	bool IsSeeded() const { return m_Seeded; }
+
+	// Returns 32 random bits.
+	unsigned int RandomBits();
+
+	// Returns an int in [Min, Max], like random_int.
+	int RandomInt(int Min, int Max);
+
+	// Returns a float in [0, 1).
+	float RandomFloat();
+
+private:
+	uint64_t m_State;
+	uint64_t m_Increment;
+	bool m_Seeded;
+};
+
+#endif // GAME_PRNG_H
@@ -5,6 +5,7 @@
 #include <game/server/gamecontext.h>
 #include <game/mapitems.h>
 #include <game/server/gameworld.h>
+#include <game/prng.h>
 
 #include <lunartee/datacontroller.h>
 
@@ -84,6 +85,9 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 	m_pPlayer = pPlayer;
 	m_Pos = Pos;
 
+	if(pPlayer->IsBot())
+		GameServer()->m_pBotController->AIScheduler()->OnBotSpawn(this);
+
 	m_Core.Reset();
 	m_Core.Init(&GameWorld()->m_Core, Collision());
 	m_Core.m_Pos = m_Pos;
@@ -599,7 +603,12 @@ void CCharacter::OnWeaponFire(int Weapon)
 
 void CCharacter::Tick()
 {
-	DoBotActions();
+	// bots think in CBotAIScheduler, a decided attack only lasts for the tick it was made
+	if(m_pPlayer->IsBot() && m_Botinfo.m_LastThinkTick != Server()->Tick())
+	{
+		m_Input.m_Fire = 0;
+		m_LatestInput.m_Fire = 0;
+	}
 
 	if(!m_Alive)
 		return;
@@ -876,7 +885,7 @@ bool CCharacter::TakeDamage(vec2 Force, int Dmg, int From, int Weapon)
 			// create pickup
 			if((GameServer()->GetPlayer(From) && !GameServer()->GetPlayer(From)->IsBot() && GameServer()->GetPlayer(From)->IsDonor()) || (Pickable() && (GameServer()->GetPlayer(From) && !GameServer()->GetPlayer(From)->IsBot()) && Weapon == WEAPON_HAMMER))
 			{
-				GameServer()->m_pController->GiveDrop(From, m_pPlayer->m_pBotData);	
+				GameServer()->m_pController->GiveDrop(GameWorld(), From, m_pPlayer->m_pBotData);	
 				Die(From, Weapon);
 			}
 
@@ -1077,12 +1086,24 @@ void CCharacter::Freeze(float Seconds)
 	m_FreezeEndTick = m_FreezeStartTick + Server()->TickSpeed() * Seconds;
 }
 
-void CCharacter::DoBotActions()
+void CCharacter::BotThink(CBotThinkResult *pResult, CPrng *pRandom)
 {
-	if(!NeedActive())
+	pResult->m_Active = NeedActive();
+	if(!pResult->m_Active)
 		return;
 
-	CCharacter *pOldTarget = GameServer()->GetPlayerChar(m_Botinfo.m_Target);
+	// only read the world here, this runs on the bot AI workers. Everything
+	// the bot decides goes into pResult and is applied in BotApply.
+	CBotInfo &Info = pResult->m_Botinfo;
+	CNetObj_PlayerInput &Input = pResult->m_Input;
+	CNetObj_PlayerInput &LatestInput = pResult->m_LatestInput;
+	int &ActiveWeapon = pResult->m_ActiveWeapon;
+	Info = m_Botinfo;
+	Input = m_Input;
+	LatestInput = m_LatestInput;
+	ActiveWeapon = m_ActiveWeapon;
+
+	CCharacter *pOldTarget = GameServer()->GetPlayerChar(Info.m_Target);
 	SBotData *pBotData = m_pPlayer->m_pBotData;
 
 	// Refind target
@@ -1091,52 +1112,52 @@ void CCharacter::DoBotActions()
 	{
 		if(pClosestChr != pOldTarget && !pOldTarget)
 		{
-			m_Botinfo.m_Target = pClosestChr->GetCID();
-			m_Botinfo.m_LastTargetPos = pClosestChr->m_Pos;
+			Info.m_Target = pClosestChr->GetCID();
+			Info.m_LastTargetPos = pClosestChr->m_Pos;
 		}
 	}
 	else 
-		m_Botinfo.m_Target = -1;
+		Info.m_Target = -1;
 
 	// reset attack
-	m_Input.m_Fire = 0;
-	m_LatestInput.m_Fire = 0;
+	Input.m_Fire = 0;
+	LatestInput.m_Fire = 0;
 	// Jump
-	vec2 NeedCheckPos = m_Pos + vec2(m_Core.m_Vel.x, 0) + ((m_Core.m_Vel.x > 0 && m_Botinfo.m_Direction == 0) ? vec2(0,0) : vec2(m_Botinfo.m_Direction * 48.0f, 0));
+	vec2 NeedCheckPos = m_Pos + vec2(m_Core.m_Vel.x, 0) + ((m_Core.m_Vel.x > 0 && Info.m_Direction == 0) ? vec2(0,0) : vec2(Info.m_Direction * 48.0f, 0));
 	if(m_PrevInput.m_Jump == 0 && !CheckPos(vec2(m_Pos.x, m_Pos.y - 32.0f)))
 	{
-		if(CheckPos(NeedCheckPos) && (IsGrounded() || m_Pos.x != m_Botinfo.m_LastGroundPos.x))
+		if(CheckPos(NeedCheckPos) && (IsGrounded() || m_Pos.x != Info.m_LastGroundPos.x))
 		{
-			m_Input.m_Jump = 1;
+			Input.m_Jump = 1;
 		}
 		else 
-			m_Input.m_Jump = 0;
+			Input.m_Jump = 0;
 
 		// If collison bot
 		CCharacter *pCollison = GameWorld()->ClosestCharacter(NeedCheckPos, 5.0f, this);
 		if(pCollison &&	pCollison->GetPlayer()->IsBot() && IsGrounded())
 		{
-			m_Input.m_Jump = 1;
+			Input.m_Jump = 1;
 		}
 
 	}
 	else 
 	{
-		m_Input.m_Jump = 0;
+		Input.m_Jump = 0;
 	}
 	// If Target
-	CCharacter *pTarget = GameServer()->GetPlayerChar(m_Botinfo.m_Target);
+	CCharacter *pTarget = GameServer()->GetPlayerChar(Info.m_Target);
 	if(pTarget)
 	{
 		// Reset random angle
-		if(abs(m_Botinfo.m_LastTargetPos.y - pTarget->m_Pos.y) > 1.0f || abs(m_Botinfo.m_LastTargetPos.x - pTarget->m_Pos.x) > 1.0f)
+		if(abs(Info.m_LastTargetPos.y - pTarget->m_Pos.y) > 1.0f || abs(Info.m_LastTargetPos.x - pTarget->m_Pos.x) > 1.0f)
 		{
-			m_Botinfo.m_RandomPos.x = random_int(-12.f, 12.);
-			m_Botinfo.m_RandomPos.y = random_int(-12.f, 12.f);
+			Info.m_RandomPos.x = pRandom->RandomInt(-12.f, 12.);
+			Info.m_RandomPos.y = pRandom->RandomInt(-12.f, 12.f);
 		}
 		else
 		{
-			m_Botinfo.m_RandomPos = vec2(0, 0);
+			Info.m_RandomPos = vec2(0, 0);
 		}
 
 		// Move
@@ -1144,14 +1165,14 @@ void CCharacter::DoBotActions()
 		{
 			if(pTarget->m_Pos.x - m_Pos.x > 40.0f)
 			{
-				m_Botinfo.m_Direction = 1;
+				Info.m_Direction = 1;
 			}
 			else if(pTarget->m_Pos.x - m_Pos.x < -40.0f)
 			{
-				m_Botinfo.m_Direction = -1;
+				Info.m_Direction = -1;
 			}
 			else 
-				m_Botinfo.m_Direction = 0;
+				Info.m_Direction = 0;
 		}
 		else if(pBotData->m_Flags&BOTFLAG_USEGUN) 
 		{
@@ -1159,64 +1180,64 @@ void CCharacter::DoBotActions()
 			{
 				if(pTarget->m_Pos.x - m_Pos.x > 448.0f)
 				{
-					m_Botinfo.m_Direction = 1;
+					Info.m_Direction = 1;
 				}
 				else if(pTarget->m_Pos.x - m_Pos.x < -448.0f)
 				{
-					m_Botinfo.m_Direction = -1;
+					Info.m_Direction = -1;
 				}
 				else if(pTarget->m_Pos.x - m_Pos.x < 480.0f && pTarget->m_Pos.x - m_Pos.x > 0.0f)
 				{
-					m_Botinfo.m_Direction = -1;
+					Info.m_Direction = -1;
 				}
 				else if(pTarget->m_Pos.x - m_Pos.x > -480.0f && pTarget->m_Pos.x - m_Pos.x < 0.0f)
 				{
-					m_Botinfo.m_Direction = 1;
+					Info.m_Direction = 1;
 				}
 				else 
-					m_Botinfo.m_Direction = 0;
+					Info.m_Direction = 0;
 			}
 			else
 			{
 				if(pTarget->m_Pos.x - m_Pos.x > 40.0f)
 				{
-					m_Botinfo.m_Direction = 1;
+					Info.m_Direction = 1;
 				}
 				else if(pTarget->m_Pos.x - m_Pos.x < -40.0f)
 				{
-					m_Botinfo.m_Direction = -1;
+					Info.m_Direction = -1;
 				}
 				else 
-					m_Botinfo.m_Direction = 0;
+					Info.m_Direction = 0;
 			}
 		}
 		else
 		{
 			if(pTarget->m_Pos.x < m_Pos.x)
 			{
-				m_Botinfo.m_Direction = 1;
+				Info.m_Direction = 1;
 			}
 			else 
-				m_Botinfo.m_Direction = -1;
+				Info.m_Direction = -1;
 		}
 		
 		//Attack
 		if(pBotData->m_Flags&BOTFLAG_USEHAMMER)
 		{
-			if(distance(pTarget->m_Pos, m_Pos) < m_ProximityRadius + 40.0f && random_int(1, 100) <= pBotData->m_AttackProba)
+			if(distance(pTarget->m_Pos, m_Pos) < m_ProximityRadius + 40.0f && pRandom->RandomInt(1, 100) <= pBotData->m_AttackProba)
 			{
-				m_ActiveWeapon = WEAPON_HAMMER;
-				m_Input.m_Fire = 1;
-				m_LatestInput.m_Fire = 1;
+				ActiveWeapon = WEAPON_HAMMER;
+				Input.m_Fire = 1;
+				LatestInput.m_Fire = 1;
 			}
 		}
 		else if(pBotData->m_Flags&BOTFLAG_USEGUN)
 		{
-			if(distance(pTarget->m_Pos, m_Pos) > 240.0f && !Collision()->IntersectLine(pTarget->m_Pos, m_Pos, NULL, NULL) && random_int(1, 100) <= pBotData->m_AttackProba)
+			if(distance(pTarget->m_Pos, m_Pos) > 240.0f && !Collision()->IntersectLine(pTarget->m_Pos, m_Pos, NULL, NULL) && pRandom->RandomInt(1, 100) <= pBotData->m_AttackProba)
 			{
-				m_ActiveWeapon = WEAPON_GUN;
-				m_Input.m_Fire = 1;
-				m_LatestInput.m_Fire = 1;
+				ActiveWeapon = WEAPON_GUN;
+				Input.m_Fire = 1;
+				LatestInput.m_Fire = 1;
 			}
 		}
 		
@@ -1225,84 +1246,103 @@ void CCharacter::DoBotActions()
 		{
 			if(!Collision()->IntersectLine(pTarget->m_Pos, m_Pos, NULL, NULL) && ((m_Core.m_HookedPlayer == pTarget->GetCID() && distance(pTarget->m_Pos, m_Pos) > 96.0f) || (distance(pTarget->m_Pos, m_Pos) > 320.0f && distance(pTarget->m_Pos, m_Pos) < 380.0f)))
 			{
-				m_Input.m_Hook = 1;
+				Input.m_Hook = 1;
 				if(pBotData->m_Flags&BOTFLAG_USEGUN)
 				{
-					m_ActiveWeapon = WEAPON_GUN;
-					m_Input.m_Fire = 1;
-					m_LatestInput.m_Fire = 1;
+					ActiveWeapon = WEAPON_GUN;
+					Input.m_Fire = 1;
+					LatestInput.m_Fire = 1;
 				}
 			}
 			else
 			{
-				m_Input.m_Hook = 0;
+				Input.m_Hook = 0;
 			}
 		}
 
-		m_Botinfo.m_TargetPos.x = (int)(pTarget->m_Pos.x - m_Pos.x + m_Botinfo.m_RandomPos.x);
-		m_Botinfo.m_TargetPos.y = (int)(pTarget->m_Pos.y - m_Pos.y + m_Botinfo.m_RandomPos.y);
+		Info.m_TargetPos.x = (int)(pTarget->m_Pos.x - m_Pos.x + Info.m_RandomPos.x);
+		Info.m_TargetPos.y = (int)(pTarget->m_Pos.y - m_Pos.y + Info.m_RandomPos.y);
 
 		if(pBotData->m_Flags&~BOTFLAG_USEHAMMER && pBotData->m_Flags&~BOTFLAG_USEGUN)
 		{
-			m_Botinfo.m_TargetPos.x = -m_Botinfo.m_TargetPos.x;
-			m_Botinfo.m_TargetPos.y = -m_Botinfo.m_TargetPos.y;
+			Info.m_TargetPos.x = -Info.m_TargetPos.x;
+			Info.m_TargetPos.y = -Info.m_TargetPos.y;
 		}
 
-		m_Botinfo.m_LastTargetPos = pTarget->m_Pos;
+		Info.m_LastTargetPos = pTarget->m_Pos;
 	}else 
 	{
 		// Change Direction
-		int LastDirection = m_Botinfo.m_Direction;
+		int LastDirection = Info.m_Direction;
 
-		if(IsGrounded() && !CheckPos(vec2(m_Botinfo.m_LastPos.x, m_Botinfo.m_LastPos.y+m_ProximityRadius/2 + 5.0f)))
+		if(IsGrounded() && !CheckPos(vec2(Info.m_LastPos.x, Info.m_LastPos.y+m_ProximityRadius/2 + 5.0f)))
 		{
-			if(distance(m_Pos, m_Botinfo.m_LastGroundPos) < 2.0f)
-				m_Botinfo.m_Direction = -LastDirection;
+			if(distance(m_Pos, Info.m_LastGroundPos) < 2.0f)
+				Info.m_Direction = -LastDirection;
 		}
 
-		if(Server()->Tick() >= m_Botinfo.m_NextDirectionTick || ( Server()->Tick() >= m_Botinfo.m_NextDirectionTick - 150 && CheckPos(NeedCheckPos)))
+		if(Server()->Tick() >= Info.m_NextDirectionTick || ( Server()->Tick() >= Info.m_NextDirectionTick - 150 && CheckPos(NeedCheckPos)))
 		{
-			if(m_Input.m_Jump == 0 && IsGrounded())
-				m_Botinfo.m_Direction = (random_int(0, 1) && m_Botinfo.m_Direction != 0) ? (-LastDirection) : (random_int(-1, 1));
-			m_Botinfo.m_NextDirectionTick = Server()->Tick() + (m_Botinfo.m_Direction ? Server()->TickSpeed() * random_int(2, 6) : Server()->TickSpeed());
+			if(Input.m_Jump == 0 && IsGrounded())
+				Info.m_Direction = (pRandom->RandomInt(0, 1) && Info.m_Direction != 0) ? (-LastDirection) : (pRandom->RandomInt(-1, 1));
+			Info.m_NextDirectionTick = Server()->Tick() + (Info.m_Direction ? Server()->TickSpeed() * pRandom->RandomInt(2, 6) : Server()->TickSpeed());
 		}
 
 		// set character angle
-		m_Botinfo.m_TargetPos = vec2(m_Botinfo.m_Direction * 32.0f, 0);
+		Info.m_TargetPos = vec2(Info.m_Direction * 32.0f, 0);
 	}
 
-	m_Input.m_TargetX = m_Botinfo.m_NowTargetPos.x;
-	m_Input.m_TargetY = m_Botinfo.m_NowTargetPos.y;
-	m_LatestInput.m_TargetX = m_Input.m_TargetX;
-	m_LatestInput.m_TargetY = m_Input.m_TargetY;
+	Input.m_TargetX = Info.m_NowTargetPos.x;
+	Input.m_TargetY = Info.m_NowTargetPos.y;
+	LatestInput.m_TargetX = Input.m_TargetX;
+	LatestInput.m_TargetY = Input.m_TargetY;
 
-	if(m_Botinfo.m_Direction)
+	if(Info.m_Direction)
 	{
-		if(distance(m_Botinfo.m_NowTargetPos, m_Botinfo.m_TargetPos) > 24.0f)
-			m_Botinfo.m_NowTargetPos += normalize(m_Botinfo.m_TargetPos - m_Botinfo.m_NowTargetPos) * 16.0f;
+		if(distance(Info.m_NowTargetPos, Info.m_TargetPos) > 24.0f)
+			Info.m_NowTargetPos += normalize(Info.m_TargetPos - Info.m_NowTargetPos) * 16.0f;
 		else
-			m_Botinfo.m_NowTargetPos = m_Botinfo.m_TargetPos;
+			Info.m_NowTargetPos = Info.m_TargetPos;
 	}
 
 	CCharacter *pUnder = GameWorld()->ClosestCharacter(vec2(m_Pos.x, m_Pos.y + 32.0f), 5.0f, this);
 	if(pUnder && pUnder->GetPlayer()->IsBot())
 	{
-		m_Botinfo.m_Direction = -m_Botinfo.m_Direction;
+		Info.m_Direction = -Info.m_Direction;
 	}
 
 	CCharacter *pAbove = GameWorld()->ClosestCharacter(vec2(m_Pos.x, m_Pos.y - 32.0f), 5.0f, this);
 	if(pAbove && pAbove->GetPlayer()->IsBot())
 	{
-		m_Botinfo.m_Direction = -m_Botinfo.m_Direction;
+		Info.m_Direction = -Info.m_Direction;
 	}
 
 	if(IsGrounded())
-		m_Botinfo.m_LastGroundPos = m_Pos;
+		Info.m_LastGroundPos = m_Pos;
 	
-	m_Botinfo.m_LastPos = m_Pos;
+	Info.m_LastPos = m_Pos;
 	
-	m_Botinfo.m_LastVel = m_Core.m_Vel;
-	m_Input.m_Direction = m_Botinfo.m_Direction;
+	Info.m_LastVel = m_Core.m_Vel;
+	Input.m_Direction = Info.m_Direction;
+
+	if(!pTarget)
+		Info.m_ThinkState = BOTTHINK_IDLE;
+	else if(Input.m_Fire || Input.m_Hook)
+		Info.m_ThinkState = BOTTHINK_ATTACK;
+	else
+		Info.m_ThinkState = BOTTHINK_CHASE;
+}
+
+
+void CCharacter::BotApply(const CBotThinkResult *pResult)
+{
+	if(!pResult->m_Active)
+		return;
+
+	m_Botinfo = pResult->m_Botinfo;
+	m_Input = pResult->m_Input;
+	m_LatestInput = pResult->m_LatestInput;
+	m_ActiveWeapon = pResult->m_ActiveWeapon;
 }
 
 CCharacter *CCharacter::FindTarget(vec2 Pos, float Radius)
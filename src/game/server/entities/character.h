@@ -182,10 +182,25 @@ public:
 
 		vec2 m_NowTargetPos;
 		vec2 m_TargetPos;
+
+		// CBotAIScheduler
+		int m_ThinkState;
+		int m_LastThinkTick;
 	};
 	CBotInfo m_Botinfo;
 
-	void DoBotActions();
+	// what one think of the bot decided, see CBotAIScheduler
+	struct CBotThinkResult
+	{
+		bool m_Active;
+		CBotInfo m_Botinfo;
+		CNetObj_PlayerInput m_Input;
+		CNetObj_PlayerInput m_LatestInput;
+		int m_ActiveWeapon;
+	};
+
+	void BotThink(CBotThinkResult *pResult, class CPrng *pRandom);
+	void BotApply(const CBotThinkResult *pResult);
 	CCharacter *FindTarget(vec2 Pos, float Radius);
 	bool Pickable() { return m_Botinfo.m_Pickable; }
 	bool CheckPos(vec2 CheckPos);
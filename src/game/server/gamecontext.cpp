@@ -3,6 +3,7 @@
 #include <new>
 
 #include <mutex>
+#include <set>
 #include <thread>
 
 #include <base/color.h>
@@ -22,6 +23,7 @@
 
 #include <engine/shared/config.h>
 #include <engine/shared/map.h>
+#include <engine/shared/profiler.h>
 
 #include <lunartee/localization//localization.h>
 #include <engine/server/crypt.h>
@@ -64,6 +66,10 @@ void CGameContext::Construct(int Resetting)
 
 	m_pMainWorld = nullptr;
 
+	m_PreloadJobs.clear();
+	m_PreloadedWorlds.clear();
+	mem_zero(&m_PreloadStats, sizeof(m_PreloadStats));
+
 	if(Resetting==NO_RESET)
 		m_pVoteOptionHeap = new CHeap();
 }
@@ -80,6 +86,13 @@ CGameContext::CGameContext()
 
 CGameContext::~CGameContext()
 {
+	for(auto &Job : m_PreloadJobs)
+	{
+		Job.second->m_Cancelled = true;
+		while(Job.second->Status() != IJob::STATE_DONE)
+			thread_yield();
+		delete Job.second->m_pWorld;
+	}
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		delete m_apPlayers[i];
 	for(auto &pPlayer : m_vpBotPlayers)
@@ -120,22 +133,16 @@ void CGameContext::Clear()
 	m_Tuning = Tuning;
 }
 
-CGameWorld *CGameContext::CreateNewWorld(IMap *pMap, const char *WorldName, bool Menu)
+void CGameContext::BuildWorld(CGameWorld *pWorld, IMap *pMap, bool Menu)
 {
-	CUuid Uuid = CalculateUuid(WorldName);
-	m_pWorlds[Uuid] = new CGameWorld();
-
-	m_pWorlds[Uuid]->SetGameServer(this);
+	pWorld->SetGameServer(this);
 
-	m_pWorlds[Uuid]->Layers()->Init(pMap);
-	m_pWorlds[Uuid]->Collision()->Init(m_pWorlds[Uuid]->Layers());
+	pWorld->Layers()->Init(pMap);
+	pWorld->Collision()->Init(pWorld->Layers());
 
-	m_pWorlds[Uuid]->InitSpawnPos();
+	pWorld->InitSpawnPos();
 
-	m_pWorlds[Uuid]->m_Menu = Menu;
-
-	if(!Menu && !m_pMainWorld)
-		m_pMainWorld = m_pWorlds[Uuid];
+	pWorld->m_Menu = Menu;
 
 	int Start, Num;
 	pMap->GetType(MAPITEMTYPE_JSON, &Start, &Num);
@@ -151,18 +158,170 @@ CGameWorld *CGameContext::CreateNewWorld(IMap *pMap, const char *WorldName, bool
 			nlohmann::json Json = nlohmann::json::parse(pBuf);
 
 			if(!Json["PagesNum"].empty() && Json["PagesNum"].is_number_integer())
-				m_pWorlds[Uuid]->m_MenuPagesNum = Json["PagesNum"].get<int>();
+				pWorld->m_MenuPagesNum = Json["PagesNum"].get<int>();
 
-			for(int i = 1; i < m_pWorlds[Uuid]->m_MenuPagesNum; i ++)
+			for(int i = 1; i < pWorld->m_MenuPagesNum; i ++)
 			{
-				str_copy(m_pWorlds[Uuid]->m_MenuLanguages[i], Json[std::to_string(i)].get<std::string>().c_str());
+				str_copy(pWorld->m_MenuLanguages[i], Json[std::to_string(i)].get<std::string>().c_str());
 			}
 
 			delete[] pBuf;
 		}
 	}
+}
+
+CGameWorld *CGameContext::PublishWorld(CUuid Uuid, CGameWorld *pWorld)
+{
+	pWorld->InitSpawnPointIDs();
+
+	uint64_t Stream;
+	mem_copy(&Stream, &Uuid, sizeof(Stream));
+	pWorld->Random()->Seed(m_WorldSeed, Stream);
+
+	m_pWorlds[Uuid] = pWorld;
+
+	if(!pWorld->m_Menu && !m_pMainWorld)
+		m_pMainWorld = pWorld;
+
+	return pWorld;
+}
+
+CGameWorld *CGameContext::CreateNewWorld(IMap *pMap, const char *WorldName, bool Menu)
+{
+	CGameWorld *pWorld = new CGameWorld();
+	BuildWorld(pWorld, pMap, Menu);
+	return PublishWorld(CalculateUuid(WorldName), pWorld);
+}
+
+CGameWorld *CGameContext::EnterWorld(IMap *pMap, const char *WorldName, bool Menu)
+{
+	CUuid Uuid = CalculateUuid(WorldName);
+
+	// a running preload is waited for, it's further along than a new build.
+	// A queued one may sit behind other jobs on the small pool, so the world
+	// is built now and the job does nothing once it gets its turn
+	if(m_PreloadJobs.count(Uuid))
+	{
+		m_PreloadJobs[Uuid]->m_Cancelled = true;
+		if(m_PreloadJobs[Uuid]->Status() != IJob::STATE_PENDING)
+			FinishWorldPreload(Uuid, true);
+	}
+
+	if(m_pWorlds.count(Uuid))
+	{
+		if(m_PreloadedWorlds.erase(Uuid))
+			m_PreloadStats.m_Hits++;
+		return m_pWorlds[Uuid];
+	}
+
+	if(!Menu)
+		m_PreloadStats.m_Misses++;
+	return CreateNewWorld(pMap, WorldName, Menu);
+}
+
+void CGameContext::CWorldPreloadJob::Run()
+{
+	if(m_Cancelled)
+		return;
+	m_pWorld = new CGameWorld();
+	m_pGameServer->BuildWorld(m_pWorld, m_pMap, false);
+}
+
+void CGameContext::StartWorldPreload(IMap *pMap, const char *WorldName)
+{
+	CUuid Uuid = CalculateUuid(WorldName);
+	if(m_pWorlds.count(Uuid) || m_PreloadJobs.count(Uuid))
+		return;
+
+	m_PreloadJobs[Uuid] = std::make_shared<CWorldPreloadJob>(this, pMap);
+	Server()->CreateNewTheardJob(m_PreloadJobs[Uuid]);
+	m_PreloadStats.m_Preloads++;
+}
+
+void CGameContext::FinishWorldPreload(CUuid Uuid, bool Wait)
+{
+	std::shared_ptr<CWorldPreloadJob> pJob = m_PreloadJobs[Uuid];
+	if(pJob->Status() != IJob::STATE_DONE)
+	{
+		if(!Wait)
+			return;
+		while(pJob->Status() != IJob::STATE_DONE)
+			thread_yield();
+	}
+
+	// the job is done with the world, hand it over in one step
+	m_PreloadJobs.erase(Uuid);
+	if(!pJob->m_pWorld)
+		return;
+	if(m_pWorlds.count(Uuid))
+	{
+		delete pJob->m_pWorld;
+		return;
+	}
+
+	PublishWorld(Uuid, pJob->m_pWorld);
+	m_PreloadedWorlds.insert(Uuid);
+}
+
+int CGameContext::WorldPreloadTargets() const
+{
+	int Targets = PRELOAD_NONE;
+	float Border = g_Config.m_SvWorldPreloadDistance * 32.0f;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!m_apPlayers[i] || !Server()->ClientIngame(i))
+			continue;
+
+		// leaving the menu goes to the main world
+		CGameWorld *pWorld = m_apPlayers[i]->GameWorld();
+		if(pWorld->m_Menu)
+		{
+			Targets = PRELOAD_MAIN;
+			continue;
+		}
+
+		CCharacter *pChr = m_apPlayers[i]->GetCharacter();
+		if(!pChr)
+			continue;
+
+		vec2 Pos = pChr->m_Pos;
+		vec2 Size = vec2(pWorld->Collision()->GetWidth(), pWorld->Collision()->GetHeight()) * 32.0f;
+		if(Pos.x < Border || Pos.y < Border || Pos.x > Size.x - Border || Pos.y > Size.y - Border)
+			return PRELOAD_ALL;
+	}
+	return Targets;
+}
+
+void CGameContext::UpdateWorldPreload()
+{
+	// publish finished worlds
+	std::vector<CUuid> vDone;
+	for(auto &Job : m_PreloadJobs)
+	{
+		if(Job.second->Status() == IJob::STATE_DONE)
+			vDone.push_back(Job.first);
+	}
+	for(auto &Uuid : vDone)
+		FinishWorldPreload(Uuid, false);
 
-	return m_pWorlds[Uuid];
+	if(!g_Config.m_SvWorldPreload || Server()->Tick() % (Server()->TickSpeed() / 5) != 0)
+		return;
+	int Targets = WorldPreloadTargets();
+	if(Targets == PRELOAD_NONE)
+		return;
+
+	// there are no links between the worlds, near a border every loaded map
+	// is a possible next one
+	for(int i = 0; i < Server()->GetLoadedMapNum(); i++)
+	{
+		const char *pMapName;
+		bool Menu;
+		IMap *pMap = Server()->GetLoadedMap(i, &pMapName, &Menu);
+		if(!pMap || Menu)
+			continue;
+		if(Targets == PRELOAD_ALL || str_comp(pMapName, Server()->GetMainMap()) == 0)
+			StartWorldPreload(pMap, pMapName);
+	}
 }
 
 class CCharacter *CGameContext::GetPlayerChar(int ClientID)
@@ -296,7 +455,7 @@ void CGameContext::SendChatTarget(int To, const char *pText)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, To);
 }
 
-void CGameContext::SendChatTarget_Localization(int To, const char *pText, ...)
+void CGameContext::SendChatTarget_Localization(int To, CLocalizeKey Text, ...)
 {
 	int Start = (To < 0 ? 0 : To);
 	int End = (To < 0 ? MAX_CLIENTS : To+1);
@@ -310,14 +469,14 @@ void CGameContext::SendChatTarget_Localization(int To, const char *pText, ...)
 	std::string Buffer;
 	
 	va_list VarArgs;
-	va_start(VarArgs, pText);
+	va_start(VarArgs, Text);
 	
 	for(int i = Start; i < End; i++)
 	{
 		if(m_apPlayers[i])
 		{
 			Buffer.clear();
-			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), pText, VarArgs);
+			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), Text, VarArgs);
 
 			Msg.m_pMessage = Buffer.c_str();
 			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, i);
@@ -386,7 +545,7 @@ void CGameContext::SendBroadcast(const char *pText, int ClientID)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
 }
 
-void CGameContext::SendBroadcast_Localization(const char *pText, int ClientID, ...)
+void CGameContext::SendBroadcast_Localization(CLocalizeKey Text, int ClientID, ...)
 {
 	CNetMsg_Sv_Broadcast Msg;
 	int Start = (ClientID < 0 ? 0 : ClientID);
@@ -403,7 +562,7 @@ void CGameContext::SendBroadcast_Localization(const char *pText, int ClientID, .
 	// only for server demo record
 	if(ClientID < 0)
 	{
-		Server()->Localization()->Format_VL(Buffer, "en", _(pText), VarArgs);
+		Server()->Localization()->Format_VL(Buffer, "en", Text, VarArgs);
 		Msg.m_pMessage = Buffer.c_str();
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NOSEND, -1);
 	}
@@ -413,7 +572,7 @@ void CGameContext::SendBroadcast_Localization(const char *pText, int ClientID, .
 		if(m_apPlayers[i])
 		{
 			Buffer.clear();
-			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), _(pText), VarArgs);
+			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), Text, VarArgs);
 			
 			Msg.m_pMessage = Buffer.c_str();
 			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, i);
@@ -548,7 +707,7 @@ void CGameContext::OnTick()
 	for(auto& BotID : m_vDeadBots)
 	{
 		if(m_vpBotPlayers[BotID]->m_pBotData->m_Type == EBotType::BOTTYPE_TRADER)
-			Datas()->Trade()->RemoveTrade(-BotID);
+			Datas()->Trade()->RemoveTrade(BotID);
 
 		m_vpBotPlayers[BotID]->m_pBotData->m_Count--;
 
@@ -557,6 +716,8 @@ void CGameContext::OnTick()
 	}
 	m_vDeadBots.clear();
 
+	UpdateWorldPreload();
+
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		if(m_apPlayers[i])
@@ -576,8 +737,25 @@ void CGameContext::OnTick()
 		}
 	}
 
+	m_pBotController->AIScheduler()->Tick();
+
+	// worlds nobody is in only tick every other tick while the watchdog sheds load
+	std::set<CGameWorld *> ActiveWorlds;
+	bool SkipIdleWorlds = Server()->LoadShedLevel() >= IServer::LOADSHED_IDLE_WORLDS && (Server()->Tick() % 2);
+	if(SkipIdleWorlds)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(m_apPlayers[i])
+				ActiveWorlds.insert(FindWorldWithClientID(i));
+		}
+	}
+
 	for(auto& pWorld : m_pWorlds)
 	{
+		if(SkipIdleWorlds && !ActiveWorlds.count(pWorld.second))
+			continue;
+
 		pWorld.second->m_Core.m_Tuning = m_Tuning;
 		pWorld.second->Tick();
 	}
@@ -832,9 +1010,7 @@ void CGameContext::OnClientEnter(int ClientID)
 
 void CGameContext::OnClientConnected(int ClientID, const char *WorldName, bool Menu)
 {
-	CGameWorld *pGameWorld = FindWorldWithName(WorldName);
-	if(!pGameWorld)
-		pGameWorld = CreateNewWorld(Server()->GetClientMap(ClientID), WorldName, Menu);
+	CGameWorld *pGameWorld = EnterWorld(Server()->GetClientMap(ClientID), WorldName, Menu);
 
 	if(m_apPlayers[ClientID])
 	{
@@ -855,14 +1031,24 @@ void CGameContext::OnClientConnected(int ClientID, const char *WorldName, bool M
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
 }
 
+void CGameContext::OnClientTransfer(int ClientID, const char *WorldName, bool Menu)
+{
+	CGameWorld *pGameWorld = EnterWorld(Server()->GetClientMap(ClientID), WorldName, Menu);
+
+	// keep the player, only the world it lives in changes
+	m_apPlayers[ClientID]->OnWorldTransfer(pGameWorld);
+}
+
 void CGameContext::OnClientDrop(int ClientID, const char *pReason)
 {
 	AbortVoteKickOnDisconnect(ClientID);
+	// saves what changed, needs the player
+	Datas()->Item()->ClearInv(ClientID, true);
+
 	m_apPlayers[ClientID]->OnDisconnect(pReason);
 	delete m_apPlayers[ClientID];
 	m_apPlayers[ClientID] = nullptr;
-
-	Datas()->Item()->ClearInv(ClientID, false);
+	Menu()->ResetClient(ClientID);
 
 	m_VoteUpdate = true;
 
@@ -1451,7 +1637,8 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			if(!Server()->IsSixup(ClientID))
 				pPlayer->m_TeeInfos.ToSixup();
 
-			// send vote options
+			// send vote options, the client starts without any
+			Menu()->ResetClient(ClientID);
 			if(!Server()->IsInMenu(ClientID))
 			{
 				Menu()->GetMenuPage("MAIN")->m_pfnCallback(ClientID, "SHOW", "", 
@@ -1794,6 +1981,42 @@ void CGameContext::ConToWorld(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Server()->ChangeClientMap(ClientID, &Uuid);
 }
 
+void CGameContext::ConBotAIStatus(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	CBotAIScheduler *pScheduler = pSelf->m_pBotController->AIScheduler();
+	const CBotAIScheduler::SStats &Stats = pScheduler->Stats();
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "bots idle=%d chase=%d attack=%d", Stats.m_aStateBots[BOTTHINK_IDLE],
+		Stats.m_aStateBots[BOTTHINK_CHASE], Stats.m_aStateBots[BOTTHINK_ATTACK]);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "botai", aBuf);
+	str_format(aBuf, sizeof(aBuf), "thinks=%lld deferred=%lld overrun_ticks=%lld", (long long)Stats.m_Thinks,
+		(long long)Stats.m_Deferred, (long long)Stats.m_OverrunTicks);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "botai", aBuf);
+	str_format(aBuf, sizeof(aBuf), "tick_time=%.3fms max_tick_time=%.3fms budget=%.3fms threads=%d",
+		Stats.m_LastTickTime * 1000.0f / time_freq(), Stats.m_MaxTickTime * 1000.0f / time_freq(), g_Config.m_SvBotAIBudget / 1000.0f,
+		pScheduler->NumThreads() + 1);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "botai", aBuf);
+
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+		pScheduler->ResetStats();
+}
+
+void CGameContext::ConWorldPreloadStatus(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "worlds=%d pending=%d preloads=%lld hits=%lld misses=%lld", (int)pSelf->m_pWorlds.size(),
+		(int)pSelf->m_PreloadJobs.size(), (long long)pSelf->m_PreloadStats.m_Preloads, (long long)pSelf->m_PreloadStats.m_Hits,
+		(long long)pSelf->m_PreloadStats.m_Misses);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "preload", aBuf);
+
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+		mem_zero(&pSelf->m_PreloadStats, sizeof(pSelf->m_PreloadStats));
+}
+
 void CGameContext::ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -1956,12 +2179,12 @@ void CGameContext::ConTimeout(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
-const char *CGameContext::Localize(const char *pLanguageCode, const char *pText) const
+const char *CGameContext::Localize(const char *pLanguageCode, CLocalizeKey Key) const
 {
 	if(str_comp(pLanguageCode, "en") == 0)
-		return pText;
+		return Key.m_pText;
 
-	return Server()->Localization()->Localize(pLanguageCode, pText);
+	return Server()->Localization()->Localize(pLanguageCode, Key);
 }
 
 std::string CGameContext::Localize(const char *pLanguageCode, CUuid Uuid) const
@@ -1969,16 +2192,16 @@ std::string CGameContext::Localize(const char *pLanguageCode, CUuid Uuid) const
 	return Server()->Localization()->Localize(pLanguageCode, Uuid);
 }
 
-const char *CGameContext::LocalizeFormat(const char *pLanguageCode, const char *pText, ...) const
+const char *CGameContext::LocalizeFormat(const char *pLanguageCode, CLocalizeKey Text, ...) const
 {
 	va_list Args;
-	va_start(Args, pText);
+	va_start(Args, Text);
 	
 	static std::string FormatBuffer;
 
 	FormatBuffer.clear();
 
-	Server()->Localization()->Format_VL(FormatBuffer, pLanguageCode, pText, Args);
+	Server()->Localization()->Format_VL(FormatBuffer, pLanguageCode, Text, Args);
 	
 	va_end(Args);
 
@@ -2040,6 +2263,8 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("clear_votes", "", CFGFLAG_SERVER, ConClearVotes, this, "Clears the voting options");
 	Console()->Register("vote", "r", CFGFLAG_SERVER, ConVote, this, "Force a vote to yes/no");
 	Console()->Register("to_world", "r", CFGFLAG_SERVER, ConToWorld, this, "go to the world");
+	Console()->Register("bot_ai_status", "?i", CFGFLAG_SERVER, ConBotAIStatus, this, "Show bot AI scheduler stats (1 = reset them)");
+	Console()->Register("world_preload_status", "?i", CFGFLAG_SERVER, ConWorldPreloadStatus, this, "Show world preload stats (1 = reset them)");
 	
 	Console()->Register("about", "", CFGFLAG_CHAT, ConAbout, this, "Show information about the mod");
 
@@ -2060,6 +2285,11 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 
+	m_WorldSeed = (uint64_t)g_Config.m_SvWorldSeed;
+	if(!m_WorldSeed)
+		secure_random_fill(&m_WorldSeed, sizeof(m_WorldSeed));
+	m_WorldSeed = Server()->SessionSeed(IServer::SEED_WORLD, m_WorldSeed);
+
 	//if(!data) // only load once
 		//data = load_data_from_memory(internal_data);
 
@@ -2071,6 +2301,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	Datas()->Init(m_pServer, m_pStorage, this);
 
 	Sql()->CreateTables();
+	Datas()->Trade()->LoadTrades();
 
 	// reset everything here
 	//world = new GAMEWORLD;
@@ -2085,6 +2316,10 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 
 void CGameContext::OnShutdown()
 {
+	// the clients are dropped and their items queued, write what is left
+	Datas()->Trade()->SaveTrades();
+	Sql()->FlushJobs();
+
 	delete m_pController;
 	m_pController = 0;
 	Clear();
@@ -2175,8 +2410,10 @@ int CGameContext::GetPlayerNum() const
 
 CPlayer *CGameContext::GetBotWithCID(int ClientID)
 {
-	if(m_vpBotPlayers.count(ClientID))
-		return m_vpBotPlayers[ClientID];
+	// no operator[] here, the bot AI workers look bots up concurrently
+	auto Iter = m_vpBotPlayers.find(ClientID);
+	if(Iter != m_vpBotPlayers.end())
+		return Iter->second;
 	return nullptr;
 }
 
@@ -2322,6 +2559,15 @@ void CGameContext::OnUpdatePlayerServerInfo(char *aBuf, int BufSize, int ID)
 		m_apPlayers[ID]->GetTeam());
 }
 
+uint64_t CGameContext::WorldChecksum() const
+{
+	// m_pWorlds is ordered by uuid, so equal runs fold in the same order
+	uint64_t Checksum = 0;
+	for(const auto &World : m_pWorlds)
+		Checksum = (Checksum << 1 | Checksum >> 63) ^ World.second->Checksum();
+	return Checksum;
+}
+
 int CGameContext::GetOneWorldPlayerNum(CGameWorld *pGameWorld) const
 {
 	return GetPlayerNum() + GetBotNum(pGameWorld);
@@ -2339,6 +2585,8 @@ bool distCompare(std::pair<float, int> a, std::pair<float, int> b)
 
 void CGameContext::UpdatePlayerMaps(int ClientID)
 {
+	PROFILE_SCOPE(PROFILE_UPDATE_PLAYER_MAPS);
+
 	if(!Server()->ClientIngame(ClientID)) 
 		return;
 
@@ -2753,6 +3001,7 @@ void CGameContext::OnPlayerChooseLanguage(int ClientID)
 {
 	CNetMsg_Sv_VoteClearOptions Msg;
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+	Menu()->ResetClient(ClientID);
 
 	CUuid Uuid = CalculateUuid(Server()->GetMenuMap());
 
@@ -2792,7 +3041,7 @@ void CGameContext::DoRegisterLogin(const char* PinHash, int ClientID, bool Timeo
 		Buffer.append(aUuidStr);
 		Buffer.append("';");
 
-		SqlResult *pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_playerdata",
+		std::unique_ptr<SqlResult> pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_playerdata",
 			Buffer.c_str(), "*");
 
 		if(!pSqlResult)
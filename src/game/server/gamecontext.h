@@ -6,6 +6,7 @@
 #include <engine/server.h>
 #include <engine/storage.h>
 #include <engine/console.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/memheap.h>
 
 #include <lunartee/bots/botcontroller.h>
@@ -22,6 +23,8 @@
 #include "player.h"
 #include "define.h"
 
+#include <atomic>
+#include <set>
 #include <unordered_map>
 /*
 	Tick
@@ -73,6 +76,8 @@ class CGameContext : public IGameServer
 	static void ConClearVotes(IConsole::IResult *pResult, void *pUserData);
 	static void ConVote(IConsole::IResult *pResult, void *pUserData);
 	static void ConToWorld(IConsole::IResult *pResult, void *pUserData);
+	static void ConBotAIStatus(IConsole::IResult *pResult, void *pUserData);
+	static void ConWorldPreloadStatus(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
@@ -103,6 +108,55 @@ public:
 
 	void Clear();
 	CGameWorld *CreateNewWorld(IMap *pMap, const char *WorldName, bool Menu);
+	// the world a client joins, preloaded or created now
+	CGameWorld *EnterWorld(IMap *pMap, const char *WorldName, bool Menu);
+
+	// world preloading, worlds are built off the game thread before a player needs
+	// them and only become visible in m_pWorlds when published at a tick boundary
+	class CWorldPreloadJob : public IJob
+	{
+		CGameContext *m_pGameServer;
+		IMap *m_pMap;
+
+		void Run() override;
+
+	public:
+		CWorldPreloadJob(CGameContext *pGameServer, IMap *pMap) :
+			m_pGameServer(pGameServer), m_pMap(pMap), m_pWorld(nullptr), m_Cancelled(false) {}
+
+		// nullptr if the job was cancelled before it started
+		CGameWorld *m_pWorld;
+		std::atomic<bool> m_Cancelled;
+	};
+
+	struct SWorldPreloadStats
+	{
+		int64_t m_Preloads;
+		int64_t m_Hits;
+		int64_t m_Misses;
+	};
+
+	void BuildWorld(CGameWorld *pWorld, IMap *pMap, bool Menu);
+	CGameWorld *PublishWorld(CUuid Uuid, CGameWorld *pWorld);
+	void StartWorldPreload(IMap *pMap, const char *WorldName);
+	void FinishWorldPreload(CUuid Uuid, bool Wait);
+	void UpdateWorldPreload();
+	enum
+	{
+		PRELOAD_NONE = 0,
+		// a player in the menu, who goes to the main world next
+		PRELOAD_MAIN,
+		// a player near a border, every world could be next
+		PRELOAD_ALL,
+	};
+	int WorldPreloadTargets() const;
+
+	std::map<CUuid, std::shared_ptr<CWorldPreloadJob>> m_PreloadJobs;
+	std::set<CUuid> m_PreloadedWorlds;
+	SWorldPreloadStats m_PreloadStats;
+
+	// every world seeds its prng from this and its uuid
+	uint64_t m_WorldSeed;
 
 	CPlayer *m_apPlayers[MAX_CLIENTS];
 	std::unordered_map<int, CPlayer*> m_vpBotPlayers;
@@ -165,16 +219,16 @@ public:
 	// network
 	void SendMotd(int To, const char *pText);
 	void SendChatTarget(int To, const char *pText);
-	void SendChatTarget_Localization(int To, const char *pText, ...);
+	void SendChatTarget_Localization(int To, CLocalizeKey Text, ...);
 	void SendChat(int ClientID, int Team, const char *pText);
 	void SendEmoticon(int ClientID, int Emoticon);
 	void SendWeaponPickup(int ClientID, int Weapon);
 	void SendBroadcast(const char *pText, int ClientID);
-	void SendBroadcast_Localization(const char *pText, int ClientID, ...);
+	void SendBroadcast_Localization(CLocalizeKey Text, int ClientID, ...);
 
-	const char *Localize(const char *pLanguageCode, const char *pText) const;
+	const char *Localize(const char *pLanguageCode, CLocalizeKey Key) const;
 	std::string Localize(const char *pLanguageCode, CUuid Uuid) const;
-	const char *LocalizeFormat(const char *pLanguageCode, const char *pText, ...) const;
+	const char *LocalizeFormat(const char *pLanguageCode, CLocalizeKey Text, ...) const;
 
 
 	//
@@ -198,6 +252,7 @@ public:
 	void OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID) override;
 
 	void OnClientConnected(int ClientID, const char *WorldName, bool Menu) override;
+	void OnClientTransfer(int ClientID, const char *WorldName, bool Menu) override;
 	void OnClientEnter(int ClientID) override;
 	void OnClientDrop(int ClientID, const char *pReason) override;
 	void OnClientDirectInput(int ClientID, void *pInput) override;
@@ -215,6 +270,8 @@ public:
 	
 	void OnUpdatePlayerServerInfo(char *aBuf, int BufSize, int ID) override;
 
+	uint64_t WorldChecksum() const override;
+
 	int GetOneWorldPlayerNum(CGameWorld *pGameWorld) const;
 	int GetOneWorldPlayerNum(int ClientID) const override;
 
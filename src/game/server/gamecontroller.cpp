@@ -360,13 +360,13 @@ bool ItemCompare(std::pair<std::string, int> a, std::pair<std::string, int> b)
 	return (a.second > b.second);
 }
 
-void CGameController::GiveDrop(int GiveID, SBotData *pBotData)
+void CGameController::GiveDrop(CGameWorld *pWorld, int GiveID, SBotData *pBotData)
 {
 	for(unsigned i = 0;i < pBotData->m_vDrops.size();i++)
 	{
-		if(random_int(1, 100) <= pBotData->m_vDrops[i].m_DropProba)
+		if(pWorld->Random()->RandomInt(1, 100) <= pBotData->m_vDrops[i].m_DropProba)
 		{
-			int Num = random_int(pBotData->m_vDrops[i].m_MinNum, pBotData->m_vDrops[i].m_MaxNum);
+			int Num = pWorld->Random()->RandomInt(pBotData->m_vDrops[i].m_MinNum, pBotData->m_vDrops[i].m_MaxNum);
 			if(Num == 0)
 				continue;
 			Datas()->Item()->AddInvItemNum(pBotData->m_vDrops[i].m_Uuid, Num, GiveID, true, true);
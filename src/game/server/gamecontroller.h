@@ -126,7 +126,7 @@ public:
 
 	double GetTime();
 
-	void GiveDrop(int GiveID, struct SBotData *pBotData);
+	void GiveDrop(class CGameWorld *pWorld, int GiveID, struct SBotData *pBotData);
 
 	WeaponInit WeaponIniter;
 };
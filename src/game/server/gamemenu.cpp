@@ -9,30 +9,32 @@ IServer *CMenu::Server() const { return m_pGameServer->Server(); }
 CMenu::CMenu(CGameContext *pGameServer) :
     m_pGameServer(pGameServer)
 {
-    str_copy(m_aLanguageCode, "en", sizeof(m_aLanguageCode));
+    for(auto &Client : m_aClients)
+        str_copy(Client.m_aLanguageCode, "en", sizeof(Client.m_aLanguageCode));
 
     RegisterMain();
 }
 
-const char *CMenu::Localize(const char *pText) const
+const char *CMenu::Localize(int ClientID, CLocalizeKey Key) const
 {
-	return GameServer()->Localize(m_aLanguageCode, pText);
+	return GameServer()->Localize(m_aClients[ClientID].m_aLanguageCode, Key);
 }
 
-std::string CMenu::Localize(CUuid Uuid) const
+std::string CMenu::Localize(int ClientID, CUuid Uuid) const
 {
-	return GameServer()->Localize(m_aLanguageCode, Uuid);
+	return GameServer()->Localize(m_aClients[ClientID].m_aLanguageCode, Uuid);
 }
 
 CMenuOption *CMenu::FindOption(const char *pDesc, int ClientID)
 {
-	auto i = std::find_if(m_avPlayerMenu[ClientID].first.begin(), m_avPlayerMenu[ClientID].first.end(),
-        [pDesc](CMenuOption Option)
+	std::vector<CMenuOption> &vOptions = m_aClients[ClientID].m_vOptions;
+	auto i = std::find_if(vOptions.begin(), vOptions.end(),
+        [pDesc](const CMenuOption &Option)
         {
             return !str_comp(Option.m_aOption, pDesc);
         });
 
-    if(i != m_avPlayerMenu[ClientID].first.end())
+    if(i != vOptions.end())
     {
         return &(*i);
     }
@@ -107,7 +109,7 @@ void CMenu::RegisterMain()
 
 void CMenu::PreviousPage(int ClientID)
 {
-    CMenuPage *pPage = GetMenuPage(m_avPlayerMenu[ClientID].second.m_aParentName);
+    CMenuPage *pPage = GetMenuPage(m_aClients[ClientID].m_Page.m_aParentName);
 
     if(!pPage)
         return;
@@ -115,23 +117,65 @@ void CMenu::PreviousPage(int ClientID)
     pPage->m_pfnCallback(ClientID, "SHOW", "", pPage->m_pUserData);
 }
 
-void CMenu::UpdateMenu(int ClientID, std::vector<CMenuOption> Options, const char* PageName)
+void CMenu::ResetClient(int ClientID)
 {
-    if(!GameServer()->m_apPlayers[ClientID])
-        return;
+    m_aClients[ClientID].m_vOptions.clear();
+    if(GameServer()->m_apPlayers[ClientID])
+        str_copy(m_aClients[ClientID].m_aLanguageCode, GameServer()->m_apPlayers[ClientID]->GetLanguage());
+}
 
-    if(m_avPlayerMenu[ClientID].first == Options)
-        return;
+void CMenu::SendOption(int ClientID, const CMenuOption &Option, bool Add)
+{
+    if(Add)
+    {
+        CNetMsg_Sv_VoteOptionAdd Msg;
+        Msg.m_pDescription = Option.m_aOption;
+        Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+    }
+    else
+    {
+        CNetMsg_Sv_VoteOptionRemove Msg;
+        Msg.m_pDescription = Option.m_aOption;
+        Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+    }
+}
 
-    // remove options
+bool CMenu::DiffOptions(const std::vector<CMenuOption> &vOld, const std::vector<CMenuOption> &vNew,
+    std::vector<int> *pRemoved, int *pFirstAdd)
+{
+    // new options are appended, so the kept ones must be the start of the new list
+    pRemoved->clear();
+    int Kept = 0;
+    for(int i = 0; i < (int) vOld.size(); i ++)
     {
-        CNetMsg_Sv_VoteClearOptions Msg;
-	    Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
-        
-        m_avPlayerMenu[ClientID].first.clear();
+        if(Kept < (int) vNew.size() && vOld[i] == vNew[Kept])
+        {
+            Kept ++;
+            continue;
+        }
+
+        // the client would remove a kept option before this one
+        for(int k = 0; k < Kept; k ++)
+        {
+            if(str_comp(vNew[k].m_aOption, vOld[i].m_aOption) == 0)
+                return false;
+        }
+        pRemoved->push_back(i);
     }
-    
-    str_copy(m_aLanguageCode, GameServer()->m_apPlayers[ClientID]->GetLanguage());
+    *pFirstAdd = Kept;
+
+    // clear and add everything
+    int NumFull = 1 + (int) vNew.size();
+    return (int) pRemoved->size() + (int) vNew.size() - Kept < NumFull;
+}
+
+void CMenu::UpdateMenu(int ClientID, std::vector<CMenuOption> Options, const char* PageName)
+{
+    if(!GameServer()->m_apPlayers[ClientID])
+        return;
+
+    CClientMenu &Client = m_aClients[ClientID];
+    str_copy(Client.m_aLanguageCode, GameServer()->m_apPlayers[ClientID]->GetLanguage());
 
     auto Page = GetMenuPage(PageName);
 
@@ -140,25 +184,37 @@ void CMenu::UpdateMenu(int ClientID, std::vector<CMenuOption> Options, const cha
         Options.push_back(CMenuOption(_("Previous Page"), "PREPAGE"));
     }
 
-    // send msg
-    for(unsigned i = 0;i < Options.size(); i ++)
+    // the descriptions as the client shows them
+    for(auto &Option : Options)
     {
-        auto &pOption = Options[i];
-
         std::string Buffer;
-        Server()->Localization()->Format(Buffer, m_aLanguageCode, pOption.m_aFormat, 
-            Localize(pOption.m_aOption));
+        Server()->Localization()->Format(Buffer, Client.m_aLanguageCode, Option.m_aFormat, 
+            Localize(ClientID, CLocalizeKey(Option.m_aOption, Option.m_OptionHash)));
 
-        str_copy(pOption.m_aOption, Buffer.c_str());
+        str_copy(Option.m_aOption, Buffer.c_str());
+    }
 
-        CNetMsg_Sv_VoteOptionAdd Msg;
-        Msg.m_pDescription = Buffer.c_str();
+    Client.m_Page = *Page;
+
+    std::vector<int> vRemoved;
+    int FirstAdd;
+    if(DiffOptions(Client.m_vOptions, Options, &vRemoved, &FirstAdd))
+    {
+        for(int Index : vRemoved)
+            SendOption(ClientID, Client.m_vOptions[Index], false);
+        for(unsigned i = FirstAdd; i < Options.size(); i ++)
+            SendOption(ClientID, Options[i], true);
+    }
+    else
+    {
+        CNetMsg_Sv_VoteClearOptions Msg;
         Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+
+        for(auto &Option : Options)
+            SendOption(ClientID, Option, true);
     }
-    
-    // append
-    m_avPlayerMenu[ClientID].first = Options;
-    m_avPlayerMenu[ClientID].second = *Page;
+
+    Client.m_vOptions = std::move(Options);
 }
 
 bool CMenu::UseOptions(const char *pDesc, const char *pReason, int ClientID)
@@ -173,14 +229,18 @@ bool CMenu::UseOptions(const char *pDesc, const char *pReason, int ClientID)
         return false;
     }
 
-    str_copy(m_aLanguageCode, GameServer()->m_apPlayers[ClientID]->GetLanguage());
+    CClientMenu &Client = m_aClients[ClientID];
+    str_copy(Client.m_aLanguageCode, GameServer()->m_apPlayers[ClientID]->GetLanguage());
 
     if(pOption->m_aCmd[0])
     {
-        if(str_comp(pOption->m_aCmd, "PREPAGE") == 0)
+        // the callback may send a new page, which replaces the options
+        char aCmd[VOTE_CMD_LENGTH];
+        str_copy(aCmd, pOption->m_aCmd);
+        if(str_comp(aCmd, "PREPAGE") == 0)
             PreviousPage(ClientID);
         else 
-            m_avPlayerMenu[ClientID].second.m_pfnCallback(ClientID, pOption->m_aCmd, pReason, m_avPlayerMenu[ClientID].second.m_pUserData);
+            Client.m_Page.m_pfnCallback(ClientID, aCmd, pReason, Client.m_Page.m_pUserData);
     }
     GameServer()->CreateSoundGlobal(SOUND_WEAPON_NOAMMO, ClientID);
     return true;
@@ -4,6 +4,8 @@
 #include <game/voting.h>
 #include <base/uuid.h>
 
+#include <lunartee/localization/localization.h>
+
 #include <string>
 #include <vector>
 
@@ -34,9 +36,18 @@ public:
 class CMenuOption
 {
 public:
-	CMenuOption(std::string Desc, const char* pCmd = 0, const char* pFormat = "- {STR}")
+	CMenuOption(const char* pDesc, const char* pCmd = 0, const char* pFormat = "- {STR}") :
+		CMenuOption(CLocalizeKey(pDesc), pCmd, pFormat)
+	{
+	}
+	CMenuOption(const std::string &Desc, const char* pCmd = 0, const char* pFormat = "- {STR}") :
+		CMenuOption(CLocalizeKey(Desc.c_str()), pCmd, pFormat)
 	{
-		str_copy(m_aOption, Desc.c_str());
+	}
+	CMenuOption(CLocalizeKey Desc, const char* pCmd = 0, const char* pFormat = "- {STR}")
+	{
+		str_copy(m_aOption, Desc.m_pText);
+		m_OptionHash = Desc.m_Hash;
 
 		if(!pCmd || !pCmd[0])
 			m_aCmd[0] = 0;
@@ -51,12 +62,14 @@ public:
 	CMenuOption() = default;
 
 	char m_aOption[VOTE_DESC_LENGTH];
+	uint64_t m_OptionHash;
 	char m_aCmd[VOTE_CMD_LENGTH];
 	char m_aFormat[16];
 
+	// what the client sees and sends back
 	bool operator==(const CMenuOption &Other) const
 	{
-		return mem_comp(this, &Other, sizeof(*this)) == 0;
+		return str_comp(m_aOption, Other.m_aOption) == 0 && str_comp(m_aCmd, Other.m_aCmd) == 0;
 	}
 };
 
@@ -64,7 +77,14 @@ class CMenu
 {
 	class CGameContext *m_pGameServer;
 
-    char m_aLanguageCode[16];
+	struct CClientMenu
+	{
+		char m_aLanguageCode[16];
+		CMenuPage m_Page;
+		// as the client has them, with the formatted descriptions
+		std::vector<CMenuOption> m_vOptions;
+	};
+	CClientMenu m_aClients[MAX_CLIENTS];
 
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
@@ -74,8 +94,9 @@ public:
 
 	CMenuPage *GetMenuPage(const char* PageName);
 
-	const char *Localize(const char *pText) const;
-	std::string Localize(CUuid Uuid) const;
+	// in the language of the client's menu
+	const char *Localize(int ClientID, CLocalizeKey Key) const;
+	std::string Localize(int ClientID, CUuid Uuid) const;
 	
 	void Register(const char* PageName, const char* ParentName, void *pUserData, MenuCallback Callback);
 
@@ -85,10 +106,20 @@ private:
 	void PreviousPage(int ClientID);
 	CMenuOption *FindOption(const char *pDesc, int ClientID);
 
-	std::pair<std::vector<CMenuOption>, CMenuPage> m_avPlayerMenu[MAX_CLIENTS];
 	std::vector<CMenuPage> m_vMenuPages;
 
+	void SendOption(int ClientID, const CMenuOption &Option, bool Add);
+
 public:
+	// the steps that turn the sent options into the new ones: the old ones
+	// at pRemoved are removed, the new ones from FirstAdd on are added.
+	// false if a full resend is shorter or the removals would hit the wrong
+	// option, the client removes the first option with the description
+	static bool DiffOptions(const std::vector<CMenuOption> &vOld, const std::vector<CMenuOption> &vNew,
+		std::vector<int> *pRemoved, int *pFirstAdd);
+
+	// the client has no options anymore, e.g. after a map change
+	void ResetClient(int ClientID);
 
     void UpdateMenu(int ClientID, std::vector<CMenuOption> Options, const char* PageName);
 
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <utility>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 
 //////////////////////////////////////////////////
 // game world
@@ -24,6 +25,8 @@ CGameWorld::CGameWorld()
 	m_Menu = false;
 	m_MenuPagesNum = 0;
 	m_MenuLanguages.clear();
+
+	m_Checksum = 0;
 }
 
 CGameWorld::~CGameWorld()
@@ -160,6 +163,8 @@ void CGameWorld::RemoveEntities()
 
 void CGameWorld::Tick()
 {
+	PROFILE_SCOPE(PROFILE_GAMEWORLD_TICK);
+
 	if(m_ResetRequested)
 		Reset();
 
@@ -181,6 +186,42 @@ void CGameWorld::Tick()
 		}
 
 	RemoveEntities();
+
+	if(g_Config.m_SvWorldChecksum)
+		UpdateChecksum();
+}
+
+// FNV-1a over the state that ticks change, the float bits are hashed as
+// they are since equal runs of one build give equal bits
+static void ChecksumAdd(uint64_t *pHash, const void *pData, int Size)
+{
+	const unsigned char *pBytes = (const unsigned char *)pData;
+	for(int i = 0; i < Size; i++)
+	{
+		*pHash ^= pBytes[i];
+		*pHash *= 0x100000001b3ULL;
+	}
+}
+
+void CGameWorld::UpdateChecksum()
+{
+	uint64_t Hash = 0xcbf29ce484222325ULL;
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			ChecksumAdd(&Hash, &i, sizeof(i));
+			ChecksumAdd(&Hash, &pEnt->m_Pos, sizeof(pEnt->m_Pos));
+			if(i == ENTTYPE_CHARACTER)
+			{
+				CCharacter *pChr = (CCharacter *)pEnt;
+				CCharacterCore *pCore = pChr->GetCore();
+				int aState[] = {pChr->GetCID(), pChr->GetHealth(), pCore->m_HookState, pCore->m_HookedPlayer, pCore->m_Jumped};
+				ChecksumAdd(&Hash, aState, sizeof(aState));
+				ChecksumAdd(&Hash, &pCore->m_Vel, sizeof(pCore->m_Vel));
+				ChecksumAdd(&Hash, &pCore->m_HookPos, sizeof(pCore->m_HookPos));
+			}
+		}
+	m_Checksum = Hash;
 }
 
 
@@ -269,11 +310,7 @@ void CGameWorld::InitSpawnPos()
 			{
 				vec2 Pos(x*32.0f+16.0f, y*32.0f+16.0f);
 				if(Index == TILE_MOONCENTER)
-				{
 					m_vSpawnPoints[0].push_back(Pos);
-					int ID = Server()->SnapNewID();
-					m_vSpawnPointsID.push_back(ID);
-				}
 				else 
 				{
 					m_vSpawnPoints[1].push_back(Pos);
@@ -283,6 +320,12 @@ void CGameWorld::InitSpawnPos()
 	}
 }
 
+void CGameWorld::InitSpawnPointIDs()
+{
+	for(int i = (int) m_vSpawnPointsID.size(); i < (int) m_vSpawnPoints[0].size(); i ++)
+		m_vSpawnPointsID.push_back(Server()->SnapNewID());
+}
+
 bool CGameWorld::GetSpawnPos(bool IsBot, vec2& SpawnPos)
 {
 	if(m_vSpawnPoints[IsBot].size() == 0)
@@ -294,7 +337,7 @@ bool CGameWorld::GetSpawnPos(bool IsBot, vec2& SpawnPos)
 
 	for(int i = 0;i < (int) m_vSpawnPoints[IsBot].size(); i++)
 	{
-		SpawnPos = m_vSpawnPoints[IsBot][random_int(0, m_vSpawnPoints[IsBot].size()-1)];
+		SpawnPos = m_vSpawnPoints[IsBot][m_Random.RandomInt(0, m_vSpawnPoints[IsBot].size()-1)];
 		if(!ClosestCharacter(SpawnPos, 48.0f, 0x0))
 		{
 			return true;
@@ -5,6 +5,7 @@
 
 #include <game/gamecore.h>
 #include <game/layers.h>
+#include <game/prng.h>
 #include <base/vmath.h>
 
 #include "eventhandler.h"
@@ -45,11 +46,21 @@ private:
 
 	CLayers m_Layers;
 	CCollision m_Collision;
+
+	CPrng m_Random;
+	uint64_t m_Checksum;
+
+	void UpdateChecksum();
 public:
 	class CGameContext *GameServer() { return m_pGameServer; }
 	class IServer *Server() { return m_pServer; }
 	CLayers *Layers() { return &m_Layers; }
 	CCollision *Collision() { return &m_Collision; }
+	// all randomness of the world state comes from here, so that equal
+	// seeds and inputs give equal worlds
+	CPrng *Random() { return &m_Random; }
+	// hash of the entities after the last tick, 0 unless sv_world_checksum is set
+	uint64_t Checksum() const { return m_Checksum; }
 
 	void SetLayers(CLayers Layers) { m_Layers = Layers; }
 	void SetCollision(CCollision Collision) { m_Collision = Collision; }
@@ -163,7 +174,10 @@ public:
 	*/
 	void Tick();
 
+	// InitSpawnPos only reads the map and may run off the game thread,
+	// the snap ids of the spawn points are taken by InitSpawnPointIDs
 	void InitSpawnPos();
+	void InitSpawnPointIDs();
 
 	int CheckBotInRadius(vec2 Pos, float Radius);
 
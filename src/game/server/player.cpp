@@ -86,6 +86,21 @@ void CPlayer::Reset()
 	}
 }
 
+void CPlayer::OnWorldTransfer(CGameWorld *pGameWorld)
+{
+	KillCharacter();
+	m_pGameWorld = pGameWorld;
+	m_LoadingMap = false;
+	Respawn();
+
+	// the entities of the old world are dropped from the next snapshot
+	Server()->ClearIdMap(m_ClientID);
+
+	m_PrevTuningParams = GameWorld()->m_Core.m_Tuning;
+	m_NextTuningParams = m_PrevTuningParams;
+	GameServer()->SendTuningParams(m_ClientID, m_PrevTuningParams);
+}
+
 void CPlayer::BotInit()
 {
 	if(!m_pBotData)
@@ -99,14 +114,26 @@ void CPlayer::BotInit()
 	// trader init
 	if(m_pBotData->m_Type == EBotType::BOTTYPE_TRADER)
 	{
+		int Index = 0;
 		for(auto& Trade : m_pBotData->m_vTrade)
 		{
+			// keep the offer the trader had before a restart
 			CTradeCore::STradeData TradeData;
+			if(Datas()->Trade()->TakeStoredTrade(m_pBotData->m_Uuid, Index, Trade.m_Give.m_Uuid, &TradeData))
+			{
+				Datas()->Trade()->AddTrade(m_ClientID, TradeData, true);
+				Index ++;
+				continue;
+			}
+
 			for(auto& Need : Trade.m_Needs)
-				TradeData.m_Needs[Need.m_Uuid] = random_int(Need.m_MinNum, Need.m_MaxNum);
+				TradeData.m_Needs[Need.m_Uuid] = GameWorld()->Random()->RandomInt(Need.m_MinNum, Need.m_MaxNum);
 			TradeData.m_Give.first = Trade.m_Give.m_Uuid;
-			TradeData.m_Give.second = random_int(Trade.m_Give.m_MinNum, Trade.m_Give.m_MaxNum);
+			TradeData.m_Give.second = GameWorld()->Random()->RandomInt(Trade.m_Give.m_MinNum, Trade.m_Give.m_MaxNum);
+			TradeData.m_TraderUuid = m_pBotData->m_Uuid;
+			TradeData.m_TraderIndex = Index;
 			Datas()->Trade()->AddTrade(m_ClientID, TradeData);
+			Index ++;
 		}
 	}
 	
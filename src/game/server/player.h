@@ -127,6 +127,7 @@ public:
 	IServer *Server() const;
 
 	void SetGameWorld(CGameWorld *pGameWorld) { m_pGameWorld = pGameWorld; }
+	void OnWorldTransfer(CGameWorld *pGameWorld);
 	int GetEmote() const {return m_Emote;}
 
 	void SetEmote(int Emote);
@@ -7,6 +7,18 @@
 MACRO_CONFIG_INT(SvGeneratedMap, sv_generated_map, 1, 0, 1, CFGFLAG_SERVER, "regenerate the generated map")
 MACRO_CONFIG_INT(SvTestVanilla, sv_test_vanilla, 0, 0, 1, CFGFLAG_SERVER, "auto load test vanilla datapack")
 
+MACRO_CONFIG_INT(SvBotThinkIdle, sv_bot_think_idle, 10, 1, 50, CFGFLAG_SERVER, "Ticks between two thinks of a bot without target")
+MACRO_CONFIG_INT(SvBotThinkChase, sv_bot_think_chase, 3, 1, 50, CFGFLAG_SERVER, "Ticks between two thinks of a bot chasing its target")
+MACRO_CONFIG_INT(SvBotThinkAttack, sv_bot_think_attack, 1, 1, 50, CFGFLAG_SERVER, "Ticks between two thinks of a bot attacking its target")
+MACRO_CONFIG_INT(SvBotAIBudget, sv_bot_ai_budget, 4000, 0, 20000, CFGFLAG_SERVER, "Bot AI time budget per tick in microseconds (0 = unlimited)")
+MACRO_CONFIG_INT(SvBotAIThreads, sv_bot_ai_threads, 2, 0, 16, CFGFLAG_SERVER, "Bot AI worker threads besides the game thread, read once at start")
+MACRO_CONFIG_INT(SvBotAISeed, sv_bot_ai_seed, 0, 0, 0, CFGFLAG_SERVER, "Seed of the bot decisions (0 = random)")
+MACRO_CONFIG_INT(SvMapSeed, sv_map_seed, 0, 0, 0, CFGFLAG_SERVER, "Seed of the generated map (0 = random)")
+MACRO_CONFIG_INT(SvWorldSeed, sv_world_seed, 0, 0, 0, CFGFLAG_SERVER, "Seed of the random events in the worlds, like spawns and drops (0 = random)")
+MACRO_CONFIG_INT(SvWorldChecksum, sv_world_checksum, 0, 0, 1, CFGFLAG_SERVER, "Hash the world state after every tick, replays report it to compare two runs")
+MACRO_CONFIG_INT(SvWorldPreload, sv_world_preload, 1, 0, 1, CFGFLAG_SERVER, "Build worlds in the background before a player needs them")
+MACRO_CONFIG_INT(SvWorldPreloadDistance, sv_world_preload_distance, 20, 0, 1000, CFGFLAG_SERVER, "Distance to the world border in tiles at which every loaded world gets preloaded, worlds have no links to pick the next one by")
+
 MACRO_CONFIG_STR(SvSqlDatabase, sv_sql_database, 256, "db_lunartee", CFGFLAG_SERVER, "SQL Database name")
 MACRO_CONFIG_STR(SvSqlUser, sv_sql_user, 256, "postgres", CFGFLAG_SERVER, "SQL User")
 MACRO_CONFIG_STR(SvSqlPass, sv_sql_pass, 256, "passless", CFGFLAG_SERVER, "SQL Password")
@@ -9,7 +9,8 @@
 #include "botcontroller.h"
 
 CBotController::CBotController(CGameContext *pGameServer) :
-    m_pGameServer(pGameServer)
+    m_pGameServer(pGameServer),
+    m_AIScheduler(pGameServer)
 {
     m_vBotDatas.clear();
 }
@@ -107,6 +108,12 @@ void CBotController::LoadBotData(std::string Buffer, class CDatapack *pDatapack)
 void CBotController::OnCreateBot()
 {
     if(m_vBotDatas.empty())
+    {
+        return;
+    }
+
+    // new bots only add load while the watchdog is shedding it
+    if(GameServer()->Server()->LoadShedLevel() >= IServer::LOADSHED_BOT_SPAWN)
     {
         return;
     }
@@ -120,7 +127,7 @@ void CBotController::OnCreateBot()
 		int BotNum = GameServer()->GetBotNum(pWorld.second);
 		while(BotNum < NeedSpawn)
 		{
-			GameServer()->CreateBot(pWorld.second, RandomBotData());
+			GameServer()->CreateBot(pWorld.second, RandomBotData(pWorld.second));
 
 			BotNum ++;
 		}
@@ -129,18 +136,18 @@ void CBotController::OnCreateBot()
     return;
 }
 
-SBotData *CBotController::RandomBotData()
+SBotData *CBotController::RandomBotData(CGameWorld *pWorld)
 {
 	int RandomID;
 	do
 	{
-		RandomID = random_int(0, (int) m_vBotDatas.size()-1);
+		RandomID = pWorld->Random()->RandomInt(0, (int) m_vBotDatas.size()-1);
 	}
-	while(random_int(1, 100) > m_vBotDatas[RandomID].m_SpawnProba);
+	while(pWorld->Random()->RandomInt(1, 100) > m_vBotDatas[RandomID].m_SpawnProba);
 
     if(m_vBotDatas[RandomID].m_Type == EBotType::BOTTYPE_TRADER && m_vBotDatas[RandomID].m_Count)
     {
-        return RandomBotData();
+        return RandomBotData(pWorld);
     }
 
 	return &m_vBotDatas[RandomID];
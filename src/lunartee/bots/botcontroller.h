@@ -2,6 +2,7 @@
 #define LUNARTEE_BOTCONTROLLER_H
 
 #include "botdata.h"
+#include "botscheduler.h"
 
 #include <string>
 #include <vector>
@@ -11,12 +12,15 @@ class CBotController
     class CGameContext *m_pGameServer;
 
     std::vector<SBotData> m_vBotDatas;
+    CBotAIScheduler m_AIScheduler;
 private:
     class CGameContext *GameServer() { return m_pGameServer; }
 public:
     CBotController(class CGameContext *pGameServer);
+
+    CBotAIScheduler *AIScheduler() { return &m_AIScheduler; }
     
-    SBotData *RandomBotData();
+    SBotData *RandomBotData(class CGameWorld *pWorld);
 
     void LoadBotData(std::string Buffer, class CDatapack *pDatapack);
     
@@ -0,0 +1,181 @@
+#include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
+
+#include <game/prng.h>
+#include <game/server/gamecontext.h>
+
+#include <algorithm>
+
+#include "botscheduler.h"
+
+void CBotAIScheduler::CThinkJob::Run()
+{
+    m_pScheduler->ThinkRange(m_Start, m_End);
+}
+
+CBotAIScheduler::CBotAIScheduler(CGameContext *pGameServer) :
+    m_pGameServer(pGameServer)
+{
+    m_vThinkQueue.clear();
+    m_vpJobs.clear();
+    m_NumThreads = -1;
+    m_Seed = 0;
+    m_ThinkTick = 0;
+    m_ThinkStart = 0;
+    m_ThinkBudget = 0;
+    m_OverBudget = false;
+    ResetStats();
+}
+
+IServer *CBotAIScheduler::Server() const
+{
+    return m_pGameServer->Server();
+}
+
+void CBotAIScheduler::ResetStats()
+{
+    mem_zero(&m_Stats, sizeof(m_Stats));
+}
+
+int CBotAIScheduler::ThinkInterval(int State) const
+{
+    int Interval;
+    switch(State)
+    {
+    case BOTTHINK_ATTACK: Interval = g_Config.m_SvBotThinkAttack; break;
+    case BOTTHINK_CHASE: Interval = g_Config.m_SvBotThinkChase; break;
+    default: Interval = g_Config.m_SvBotThinkIdle;
+    }
+
+    // the watchdog asks for less thinking while the server can't keep up
+    if(Server()->LoadShedLevel() >= IServer::LOADSHED_BOT_AI)
+        Interval *= 2;
+    return Interval;
+}
+
+void CBotAIScheduler::OnBotSpawn(CCharacter *pChr)
+{
+    // give every bot its own phase so bots spawned in the same tick don't think together
+    pChr->m_Botinfo.m_ThinkState = BOTTHINK_IDLE;
+    pChr->m_Botinfo.m_LastThinkTick = Server()->Tick() - absolute(pChr->GetCID()) % ThinkInterval(BOTTHINK_IDLE);
+}
+
+void CBotAIScheduler::ThinkRange(int Start, int End)
+{
+    PROFILE_SCOPE(PROFILE_BOT_THINK);
+
+    for(int i = Start; i < End; i++)
+    {
+        if(m_ThinkBudget && (m_OverBudget || time_get() - m_ThinkStart > m_ThinkBudget))
+        {
+            m_OverBudget = true;
+            return;
+        }
+
+        SThink *pThink = &m_vThinkQueue[i];
+
+        CPrng Random;
+        Random.Seed(m_Seed ^ ((uint64_t) m_ThinkTick * 0x9e3779b97f4a7c15ULL), (uint64_t) absolute(pThink->m_pChr->GetCID()));
+
+        pThink->m_pChr->BotThink(&pThink->m_Result, &Random);
+        pThink->m_Done = true;
+    }
+}
+
+void CBotAIScheduler::Tick()
+{
+    PROFILE_SCOPE(PROFILE_BOT_AI);
+
+    if(m_NumThreads < 0)
+    {
+        // the pool can't be resized, the thread count is only read once
+        m_NumThreads = g_Config.m_SvBotAIThreads;
+        if(m_NumThreads > 0)
+            m_ThinkPool.Init(m_NumThreads);
+
+        m_Seed = g_Config.m_SvBotAISeed;
+        if(!m_Seed)
+            secure_random_fill(&m_Seed, sizeof(m_Seed));
+        m_Seed = Server()->SessionSeed(IServer::SEED_BOT_AI, m_Seed);
+    }
+
+    m_ThinkTick = Server()->Tick();
+
+    m_vThinkQueue.clear();
+    mem_zero(m_Stats.m_aStateBots, sizeof(m_Stats.m_aStateBots));
+
+    for(auto &pBotPlayer : GameServer()->m_vpBotPlayers)
+    {
+        CCharacter *pChr = pBotPlayer.second->GetCharacter();
+        if(!pChr || !pChr->IsAlive())
+            continue;
+
+        CCharacter::CBotInfo *pInfo = &pChr->m_Botinfo;
+        m_Stats.m_aStateBots[pInfo->m_ThinkState]++;
+
+        if(m_ThinkTick - pInfo->m_LastThinkTick < ThinkInterval(pInfo->m_ThinkState))
+            continue;
+
+        SThink Think;
+        Think.m_pChr = pChr;
+        Think.m_Done = false;
+        m_vThinkQueue.push_back(Think);
+    }
+
+    // the longest waiting bots first, so a spent budget never starves the same bots twice.
+    // The client id makes the order total, the bot map has no stable order of its own
+    std::sort(m_vThinkQueue.begin(), m_vThinkQueue.end(), [](const SThink &A, const SThink &B) {
+        if(A.m_pChr->m_Botinfo.m_LastThinkTick != B.m_pChr->m_Botinfo.m_LastThinkTick)
+            return A.m_pChr->m_Botinfo.m_LastThinkTick < B.m_pChr->m_Botinfo.m_LastThinkTick;
+        return A.m_pChr->GetCID() > B.m_pChr->GetCID();
+    });
+
+    m_ThinkStart = time_get();
+    m_ThinkBudget = time_freq() * g_Config.m_SvBotAIBudget / 1000000;
+    m_OverBudget = false;
+
+    // think phase, the game thread takes the first slice itself
+    int Num = (int) m_vThinkQueue.size();
+    int NumSlices = minimum(m_NumThreads + 1, maximum(Num, 1));
+    int SliceSize = (Num + NumSlices - 1) / NumSlices;
+
+    m_vpJobs.clear();
+    for(int i = 1; i < NumSlices; i++)
+    {
+        int Start = i * SliceSize;
+        int End = minimum(Start + SliceSize, Num);
+        if(Start >= End)
+            break;
+        m_vpJobs.push_back(std::make_shared<CThinkJob>(this, Start, End));
+        m_ThinkPool.Add(m_vpJobs.back());
+    }
+
+    ThinkRange(0, minimum(SliceSize, Num));
+
+    for(auto &pJob : m_vpJobs)
+    {
+        while(pJob->Status() != IJob::STATE_DONE)
+            thread_yield();
+    }
+    m_vpJobs.clear();
+
+    // apply phase
+    for(auto &Think : m_vThinkQueue)
+    {
+        if(!Think.m_Done)
+        {
+            m_Stats.m_Deferred++;
+            continue;
+        }
+
+        Think.m_pChr->BotApply(&Think.m_Result);
+        Think.m_pChr->m_Botinfo.m_LastThinkTick = m_ThinkTick;
+        m_Stats.m_Thinks++;
+    }
+
+    if(m_OverBudget)
+        m_Stats.m_OverrunTicks++;
+
+    m_Stats.m_LastTickTime = time_get() - m_ThinkStart;
+    m_Stats.m_MaxTickTime = maximum(m_Stats.m_MaxTickTime, m_Stats.m_LastTickTime);
+}
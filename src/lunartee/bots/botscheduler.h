@@ -0,0 +1,100 @@
+#ifndef LUNARTEE_BOTSCHEDULER_H
+#define LUNARTEE_BOTSCHEDULER_H
+
+#include <base/system.h>
+
+#include <engine/shared/jobs.h>
+
+#include <game/server/entities/character.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+enum EBotThinkState
+{
+    BOTTHINK_IDLE = 0,
+    BOTTHINK_CHASE,
+    BOTTHINK_ATTACK,
+    NUM_BOTTHINKS,
+};
+
+// Spreads the bot thinking over the ticks: every bot thinks at the rate of
+// its current state, and a tick stops handing out thinks once the AI time
+// budget is spent. Bots that were left out are the first ones to think on
+// the next tick.
+//
+// A tick has two phases. The think phase runs CCharacter::BotThink for all
+// due bots, split over sv_bot_ai_threads workers. Nothing moves while it
+// runs, so every bot sees the same world. The apply phase then commits the
+// results on the game thread in a fixed order. Each think gets its own
+// generator seeded from sv_bot_ai_seed, the tick and the bot, so the result
+// doesn't depend on which worker ran it.
+class CBotAIScheduler
+{
+    class CThinkJob : public IJob
+    {
+        CBotAIScheduler *m_pScheduler;
+        int m_Start;
+        int m_End;
+
+        void Run() override;
+
+    public:
+        CThinkJob(CBotAIScheduler *pScheduler, int Start, int End) :
+            m_pScheduler(pScheduler), m_Start(Start), m_End(End) {}
+    };
+
+    struct SThink
+    {
+        CCharacter *m_pChr;
+        bool m_Done;
+        CCharacter::CBotThinkResult m_Result;
+    };
+
+    class CGameContext *m_pGameServer;
+
+    std::vector<SThink> m_vThinkQueue;
+    std::vector<std::shared_ptr<CThinkJob>> m_vpJobs;
+
+    CJobPool m_ThinkPool;
+    int m_NumThreads;
+    uint64_t m_Seed;
+
+    int m_ThinkTick;
+    int64_t m_ThinkStart;
+    int64_t m_ThinkBudget;
+    std::atomic<bool> m_OverBudget;
+
+    class CGameContext *GameServer() const { return m_pGameServer; }
+    class IServer *Server() const;
+
+    void ThinkRange(int Start, int End);
+
+public:
+    struct SStats
+    {
+        int64_t m_Thinks;
+        int64_t m_Deferred;
+        int64_t m_OverrunTicks;
+        int64_t m_LastTickTime;
+        int64_t m_MaxTickTime;
+        int m_aStateBots[NUM_BOTTHINKS];
+    };
+
+    CBotAIScheduler(class CGameContext *pGameServer);
+
+    int ThinkInterval(int State) const;
+    void OnBotSpawn(CCharacter *pChr);
+
+    void Tick();
+
+    const SStats &Stats() const { return m_Stats; }
+    void ResetStats();
+    int NumThreads() const { return m_NumThreads; }
+
+private:
+    SStats m_Stats;
+};
+
+#endif
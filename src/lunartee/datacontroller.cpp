@@ -1,5 +1,6 @@
 #include <engine/storage.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/external/json/json.hpp>
 
 #include <game/server/gamecontext.h>
@@ -40,6 +41,9 @@ void CDataController::Init(IServer *pServer, IStorage *pStorage, CGameContext *p
     m_pTrade = new CTradeCore(pGameServer);
     Sql()->Init(pGameServer);
 
+    // the languages load in the background from the first tick on
+    Server()->Localization()->RequestReload();
+
     if(g_Config.m_SvTestVanilla)
         AddDatapack("https://codeload.github.com/TeeMidnight/LunarTee-Vanilla/zip/refs/heads/Test", true);
     else
@@ -110,14 +114,9 @@ void CDataController::PreloadDatapack(CDatapack &Datapack)
         Datapack.m_State = PACKSTATE_UNLOAD;
         return;
     }
-    // move the file to lunartee/datapacks/
-    char aNewPath[128], aNewFullPath[IO_MAX_PATH_LENGTH];
-    str_format(aNewPath, sizeof(aNewPath), "datapacks/%s", Datapack.m_aFileName);
-    Datas()->Storage()->GetCompletePath(IStorage::TYPE_SAVE, aNewPath, aNewFullPath, sizeof(aNewFullPath));
-    fs_rename(pPath, aNewFullPath);
+    // the pack stays in the download cache, loaded from there
 
     // load info to datapack
-    str_copy(Datapack.m_aLocalPath, aNewFullPath);
     str_copy(Datapack.m_aPackageName, Packinfo["package-name"].get<std::string>().c_str());
     str_copy(Datapack.m_aPackageID, Packinfo["package-id"].get<std::string>().c_str());
     Datapack.m_aPackageUuid = CalculateUuid(Datapack.m_aPackageID);
@@ -126,6 +125,12 @@ void CDataController::PreloadDatapack(CDatapack &Datapack)
 
 void CDataController::Tick()
 {
+    PROFILE_SCOPE(PROFILE_DATA_TICK);
+
+    Server()->Localization()->Update(Server());
+    Item()->Tick();
+    Trade()->Tick();
+
     // remove unloadable packs
     for(unsigned i = 0; i < m_Datapacks.size(); i ++)
     {
@@ -149,8 +154,8 @@ void CDataController::Tick()
                     Datapack.m_State &= ~PACKSTATE_RELOAD;
                 }else if(Datapack.m_aWebLink[0])
                 {
-                    // predownload to downloads dir
-                    m_pWebDownloader->Download(Datapack.m_aWebLink, "downloads/", DatapacksWeb);
+                    // download or revalidate the cached pack
+                    m_pWebDownloader->Download(Datapack.m_aWebLink, DatapacksWeb);
                     Datapack.m_State &= ~PACKSTATE_RELOAD;
                 }
             }else if(Datapack.m_State & PACKSTATE_PRELOAD)
@@ -244,6 +249,7 @@ void CDataController::LoadDatapack(CDatapack *pDatapack)
 
     // Load items
     Unzip.ListDir("items", LoadItems, &LoadData);
+    Item()->BuildIndex();
 
     std::string Buffer;
     Buffer.clear();
@@ -253,6 +259,8 @@ void CDataController::LoadDatapack(CDatapack *pDatapack)
     Buffer.clear();
     if(Unzip.UnzipFile(Buffer, "translations/index.json"))
         Server()->Localization()->LoadDatapack(&Unzip, Buffer);
+    // the pack's translations, also for languages that were loaded before
+    Server()->Localization()->RequestReload();
     // Load skins
     Unzip.ListDir("skins", LoadSkins, &LoadData);
 
@@ -277,84 +285,54 @@ void CUnzip::ListItem(CZipItem* pItem, UNZIP_LISTDIR_CALLBACK pfnCallback, void
 
 void CUnzip::LoadDirFile()
 {
-    for(zip_int64_t i = 0; i < zip_get_num_entries(m_pFile, 0); i ++)
+    zip_int64_t NumEntries = zip_get_num_entries(m_pFile, 0);
+    m_ItemsByPath.reserve(NumEntries);
+
+    for(zip_int64_t i = 0; i < NumEntries; i ++)
     {
-        char aPath[IO_MAX_PATH_LENGTH];
-        str_copy(aPath, zip_get_name(m_pFile, i, ZIP_FL_ENC_GUESS));
-
-        // Get All Path
-        std::vector<std::string> Files;
-        char *pBuffer;
-        pBuffer = strtok(aPath, "/");
-        for(; pBuffer; pBuffer = strtok(NULL, "/"))
-        {
-            Files.push_back(std::string(pBuffer));
-        }
-        
-        // New Path
+        const char *pName = zip_get_name(m_pFile, i, ZIP_FL_ENC_GUESS);
+        if(!pName)
+            continue;
+
+        // walk the path, every prefix is a dir that is created once
+        std::string Path;
         CZipItem *pParent = nullptr;
-        CZipItem *pItem = nullptr;
-        for(unsigned j = 0; j < Files.size(); j ++)
+        const char *pStart = pName;
+        while(*pStart)
         {
-            bool IsSame = false;
-            for(auto &ZipItem : m_pItems)
+            const char *pEnd = pStart;
+            while(*pEnd && *pEnd != '/')
+                pEnd ++;
+            if(pEnd == pStart)
             {
-                std::string Name = Files[j];
-                if(str_comp(ZipItem->m_aName, Name.c_str()))
-                    continue;
-                // Check is same path
-                bool Same = true;
-                pItem = ZipItem->m_pParent;
-
-                // check parent
-                for(int k = (int) j - 1; k >= 0; k --)
-                {
-                    if(!pItem)
-                    {
-                        Same = false;
-                        break;
-                    }
-
-                    if(str_comp(pItem->m_aName, Files[k].c_str()))
-                    {
-                        Same = false;
-                        break;
-                    }
-                    pItem = pItem->m_pParent;
-                }
-                if(pItem && pItem->m_pParent)
-                    Same = false;
-
-                if(Same)
-                {
-                    IsSame = Same;
-                    pParent = ZipItem;
-                    break;
-                }
-            }
-
-            if(IsSame && !m_pItems.empty())
+                pStart ++;
                 continue;
+            }
 
-            // append item
-            m_pItems.push_back(new CZipItem(Files[j].c_str(), pParent));
-            (*m_pItems.rbegin())->m_Children.clear();
-            if(pParent)
-                pParent->m_Children.push_back(*m_pItems.rbegin());
-            pParent = m_pItems[m_pItems.size() - 1];
+            if(!Path.empty())
+                Path += '/';
+            Path.append(pStart, pEnd - pStart);
 
-            if(str_comp(pParent->m_aName, "datapack.json") == 0) // file about this datapack
-                m_pRootDir = pParent->m_pParent;
-            if(j == Files.size() - 1)
+            CZipItem *&pItem = m_ItemsByPath[Path];
+            if(!pItem)
             {
-                zip_stat_init(&pParent->m_Stat);
-                zip_stat_index(m_pFile, i, 0, &pParent->m_Stat);
+                pItem = new CZipItem(Path.c_str() + (Path.size() - (pEnd - pStart)), pParent);
+                pItem->m_Path = Path;
+                zip_stat_init(&pItem->m_Stat);
+                m_pItems.push_back(pItem);
+                if(pParent)
+                    pParent->m_Children.push_back(pItem);
+
+                if(str_comp(pItem->m_aName, "datapack.json") == 0) // file about this datapack
+                    m_pRootDir = pParent;
             }
+            pParent = pItem;
+            pStart = *pEnd ? pEnd + 1 : pEnd;
         }
-    }
 
-    if(m_pRootDir)
-        m_pRootDir->GetPath(); // preload path
+        if(pParent)
+            zip_stat_index(m_pFile, i, 0, &pParent->m_Stat);
+    }
 }
 
 bool CUnzip::OpenFile(const char* pPath)
@@ -382,35 +360,47 @@ bool CUnzip::UnzipFile(std::string &ReadBuffer, CZipItem *pItem)
     if(!pItem)
         return 0;
 
-    if(pItem->IsDir())
+    // read behind what the buffer already holds
+    size_t Offset = ReadBuffer.size();
+    ReadBuffer.resize(Offset + FileSize(pItem));
+    if(!ReadFile(pItem, &ReadBuffer[Offset], FileSize(pItem)))
+    {
+        ReadBuffer.resize(Offset);
+        return 0;
+    }
+
+    return 1;
+}
+
+bool CUnzip::ReadFile(CZipItem *pItem, void *pBuffer, unsigned BufferSize, unsigned *pSize)
+{
+    if(!pItem)
+        return 0;
+
+    if(pItem->IsDir() || pItem->m_Stat.size > BufferSize)
         return 0;
 
-    int Error = 0;
     zip_file *pFile = zip_fopen_index(m_pFile, pItem->m_Stat.index, 0);
     if(!pFile)
     {
-        zip_error_t Err;
-        zip_error_init_with_code(&Err, Error);
-        log_error("data", "load zip file error: %s", zip_error_strerror(&Err));
+        log_error("data", "load zip file error: %s", zip_strerror(m_pFile));
         return 0;
     }
-    // READ
-    char *pBuffer = new char[pItem->m_Stat.size + 1];
-    mem_zero(pBuffer, pItem->m_Stat.size + 1);
-
-    zip_fread(pFile, pBuffer, pItem->m_Stat.size);
-
-    ReadBuffer.append(pBuffer, pItem->m_Stat.size);
 
+    zip_int64_t Size = zip_fread(pFile, pBuffer, pItem->m_Stat.size);
     zip_fclose(pFile);
+    if(Size < 0 || (zip_uint64_t) Size != pItem->m_Stat.size)
+    {
+        log_error("data", "read zip file %s failed", pItem->GetPath());
+        return 0;
+    }
 
-    if(pBuffer)
-        delete[] pBuffer;
-
+    if(pSize)
+        *pSize = (unsigned) Size;
     return 1;
 }
 
-CUuid CalculateUuid(CDatapack *pDatapack, const char* pName)
+CUuid CalculateUuid(const CDatapack *pDatapack, const char* pName)
 {
     char aUuidStr[UUID_MAXSTRSIZE];
     FormatUuid(pDatapack->m_aPackageUuid, aUuidStr, sizeof(aUuidStr));
@@ -3,6 +3,10 @@
 
 #include <zip.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "webdownloader.h"
 
 class IServer;
@@ -66,10 +70,13 @@ typedef int (*UNZIP_LISTDIR_CALLBACK)(CZipItem* pItem, CZipItem *pCallDir, CUnzi
 class CUnzip
 {
     zip *m_pFile;
+    // full path -> item, built with the tree in LoadDirFile
+    std::unordered_map<std::string, CZipItem*> m_ItemsByPath;
 public:
     std::vector<CZipItem*> m_pItems;
     CZipItem* m_pRootDir;
 
+    // pPath is relative to the datapack root
     CZipItem* FindItemWithPath(const char* pPath)
     {
         std::string Path;
@@ -81,14 +88,10 @@ public:
         }
         Path += pPath;
 
-        for(auto &pItem : m_pItems)
-        {
-            if(str_comp(pItem->GetPath(), Path.c_str()) == 0)
-            {
-                return pItem;
-            }
-        }
-        return nullptr;
+        auto Iter = m_ItemsByPath.find(Path);
+        if(Iter == m_ItemsByPath.end())
+            return nullptr;
+        return Iter->second;
     }
 
     CUnzip()
@@ -122,6 +125,11 @@ public:
     void LoadDirFile();
     bool UnzipFile(std::string &ReadBuffer, const char* pPath);
     bool UnzipFile(std::string &ReadBuffer, CZipItem *pItem);
+
+    // decompresses straight into pBuffer, fails if the file doesn't fit
+    // FileSize(pItem) is the size needed
+    static unsigned FileSize(CZipItem *pItem) { return pItem ? (unsigned) pItem->m_Stat.size : 0; }
+    bool ReadFile(CZipItem *pItem, void *pBuffer, unsigned BufferSize, unsigned *pSize = nullptr);
 };
 
 enum DatapackState
@@ -203,7 +211,7 @@ public:
     void PreloadDatapack(CDatapack &Datapack);
 };
 
-extern CUuid CalculateUuid(CDatapack *pDatapack, const char* pName);
+extern CUuid CalculateUuid(const CDatapack *pDatapack, const char* pName);
 extern CDataController g_DataController;
 extern CDataController *Datas();
 
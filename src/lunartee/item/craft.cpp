@@ -21,6 +21,12 @@ CGameContext *CCraftCore::GameServer() const
 // Public Make
 void CCraftCore::CraftItem(CUuid Uuid, int ClientID)
 {
+	if(m_pParent->IsInvSyncing(ClientID))
+	{
+		GameServer()->SendChatTarget_Localization(ClientID, _("Your items are loading, please wait"));
+		return;
+	}
+
 	CItemData *pItemInfo = m_pParent->GetItemData(Uuid);
 	if(!pItemInfo)
 	{
@@ -37,56 +43,46 @@ void CCraftCore::CraftItem(CUuid Uuid, int ClientID)
 	if(!pPlayer->GetCharacter())
 		return;
 
-	bool Makeable = true;
 	// Check the resources are enough
-	for(unsigned i = 0; i < pItemInfo->m_Needs.m_vDatas.size();i ++)
-	{
-		if(m_pParent->GetInvItemNum(std::get<0>(pItemInfo->m_Needs.m_vDatas[i]), ClientID) < std::get<1>(pItemInfo->m_Needs.m_vDatas[i]))
-		{
-			Makeable = false;
-			break;
-		}
-	}
-
-	if(!Makeable)
+	if(!m_pParent->IsCraftable(ClientID, Uuid))
 	{
 		GameServer()->SendChatTarget_Localization(ClientID, _("You don't have enough resources"));
 		return;
 	}
 
-	Makeable = true;
-
-	for(int i = 0; i < NUM_LUNARTEE_WEAPONS; i ++)
-	{
-		if(g_Weapons.m_aWeapons[i]->GetItemUuid() == Uuid)
-			if(m_pParent->GetInvItemNum(Uuid, ClientID))
-				Makeable = false;
-	}
-
-	if(!Makeable)
+	// a weapon is only had once
+	if(m_pParent->GetItemWeapon(Uuid) != -1 && m_pParent->GetInvItemNum(Uuid, ClientID))
 	{
 		GameServer()->SendChatTarget_Localization(ClientID, _("You had {UUID}"), Uuid);
 		return;
 	}
 
-	ReturnItem(pItemInfo, ClientID);
+	if(!ReturnItem(pItemInfo, ClientID))
+		GameServer()->SendChatTarget_Localization(ClientID, _("You don't have enough resources"));
 }
 
-void CCraftCore::ReturnItem(class CItemData *Item, int ClientID)
+bool CCraftCore::ReturnItem(class CItemData *Item, int ClientID)
 {
 	CPlayer *pPlayer = GameServer()->m_apPlayers[ClientID];
 	if(!pPlayer)
-		return;
+		return false;
 	
+	CInvTransaction Transaction(m_pParent, ClientID);
 	for(unsigned i = 0; i < Item->m_Needs.m_vDatas.size();i ++)
 	{
-		m_pParent->AddInvItemNum(std::get<0>(Item->m_Needs.m_vDatas[i]), -std::get<1>(Item->m_Needs.m_vDatas[i]), ClientID);
+		Transaction.Add(std::get<0>(Item->m_Needs.m_vDatas[i]), -std::get<1>(Item->m_Needs.m_vDatas[i]));
 	}
 
 	for(unsigned i = 0; i < Item->m_Gives.m_vDatas.size();i ++)
 	{
-		m_pParent->AddInvItemNum(std::get<0>(Item->m_Gives.m_vDatas[i]), std::get<1>(Item->m_Gives.m_vDatas[i]), ClientID);
+		Transaction.Add(std::get<0>(Item->m_Gives.m_vDatas[i]), std::get<1>(Item->m_Gives.m_vDatas[i]));
+	}
+
+	if(!Transaction.Commit())
+		return false;
 
+	for(unsigned i = 0; i < Item->m_Gives.m_vDatas.size();i ++)
+	{
 		if(!std::get<2>(Item->m_Gives.m_vDatas[i]))
 			continue;
 			
@@ -101,4 +97,5 @@ void CCraftCore::ReturnItem(class CItemData *Item, int ClientID)
 				std::get<0>(Item->m_Gives.m_vDatas[i]));
 		}	
 	}
+	return true;
 }
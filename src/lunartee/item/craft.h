@@ -8,7 +8,8 @@ class CCraftCore
 	class CItemCore *m_pParent;
 	class CGameContext *GameServer() const;
 
-	void ReturnItem(class CItemData *Item, int ClientID);
+	// takes the needs and gives the items in one transaction
+	bool ReturnItem(class CItemData *Item, int ClientID);
 
 public:
     CCraftCore(CItemCore *pItem);
@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "inventory.h"
+
+CInventory::CInventory()
+{
+	m_pSlotUuids = nullptr;
+	m_Dirty = false;
+}
+
+CInventory::COther *CInventory::FindOther(CUuid Uuid)
+{
+	for(auto &Other : m_vOthers)
+	{
+		if(Other.m_Uuid == Uuid)
+			return &Other;
+	}
+	return nullptr;
+}
+
+void CInventory::Grow(int Slot)
+{
+	// slots only get added by datapack loads
+	if(Slot < (int) m_vNums.size())
+		return;
+	int Size = std::max(Slot + 1, (int) m_pSlotUuids->size());
+	m_vNums.resize(Size, 0);
+	m_vChanges.resize(Size, 0);
+	m_vDirty.resize(Size, false);
+}
+
+int CInventory::Get(int Slot, CUuid Uuid) const
+{
+	if(Slot >= 0)
+		return Slot < (int) m_vNums.size() ? m_vNums[Slot] : 0;
+
+	for(auto &Other : m_vOthers)
+	{
+		if(Other.m_Uuid == Uuid)
+			return Other.m_Num;
+	}
+	return 0;
+}
+
+void CInventory::Add(int Slot, CUuid Uuid, int Num, bool Save)
+{
+	if(Slot >= 0)
+	{
+		Grow(Slot);
+		m_vNums[Slot] += Num;
+		if(Save && Num)
+		{
+			m_vChanges[Slot] += Num;
+			m_vDirty[Slot] = true;
+			m_Dirty = true;
+		}
+		return;
+	}
+
+	COther *pOther = FindOther(Uuid);
+	if(!pOther)
+	{
+		m_vOthers.push_back({Uuid, 0, 0});
+		pOther = &m_vOthers.back();
+	}
+	pOther->m_Num += Num;
+	if(Save && Num)
+	{
+		pOther->m_Change += Num;
+		m_Dirty = true;
+	}
+}
+
+void CInventory::Set(int Slot, CUuid Uuid, int Num, bool Save)
+{
+	Add(Slot, Uuid, Num - Get(Slot, Uuid), Save);
+}
+
+void CInventory::Clear()
+{
+	m_vNums.clear();
+	m_vChanges.clear();
+	m_vDirty.clear();
+	m_vOthers.clear();
+	m_Dirty = false;
+}
+
+void CInventory::Adopt(int Slot, CUuid Uuid)
+{
+	auto Iter = std::find_if(m_vOthers.begin(), m_vOthers.end(),
+		[Uuid](const COther &Other) { return Other.m_Uuid == Uuid; });
+	if(Iter == m_vOthers.end())
+		return;
+
+	Grow(Slot);
+	m_vNums[Slot] = Iter->m_Num;
+	m_vChanges[Slot] = Iter->m_Change;
+	m_vDirty[Slot] = Iter->m_Change != 0;
+	m_vOthers.erase(Iter);
+}
+
+void CInventory::TakeChanges(std::vector<std::pair<CUuid, int>> *pvChanges)
+{
+	pvChanges->clear();
+	for(int Slot = 0; Slot < (int) m_vDirty.size(); Slot++)
+	{
+		if(!m_vDirty[Slot])
+			continue;
+		if(m_vChanges[Slot])
+			pvChanges->emplace_back((*m_pSlotUuids)[Slot], m_vChanges[Slot]);
+		m_vChanges[Slot] = 0;
+		m_vDirty[Slot] = false;
+	}
+	for(auto &Other : m_vOthers)
+	{
+		if(Other.m_Change)
+			pvChanges->emplace_back(Other.m_Uuid, Other.m_Change);
+		Other.m_Change = 0;
+	}
+	m_Dirty = false;
+}
+
+void CInventory::CIterator::Skip()
+{
+	const int NumSlots = (int) m_pInventory->m_vNums.size();
+	const int Size = NumSlots + (int) m_pInventory->m_vOthers.size();
+	for(; m_Index < Size; m_Index++)
+	{
+		if(m_Index < NumSlots)
+		{
+			if(!m_pInventory->m_vNums[m_Index])
+				continue;
+			m_Current = std::make_pair((*m_pInventory->m_pSlotUuids)[m_Index], m_pInventory->m_vNums[m_Index]);
+			return;
+		}
+
+		const COther &Other = m_pInventory->m_vOthers[m_Index - NumSlots];
+		if(!Other.m_Num)
+			continue;
+		m_Current = std::make_pair(Other.m_Uuid, Other.m_Num);
+		return;
+	}
+}
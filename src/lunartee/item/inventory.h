@@ -0,0 +1,72 @@
+#ifndef LUNARTEE_INVENTORY_H
+#define LUNARTEE_INVENTORY_H
+
+#include <base/uuid.h>
+
+#include <utility>
+#include <vector>
+
+// the items of a client, the registered items flat by the slot CItemCore
+// gave them, items without a slot (e.g. of removed datapacks) after them
+class CInventory
+{
+	struct COther
+	{
+		CUuid m_Uuid;
+		int m_Num;
+		int m_Change;
+	};
+
+	const std::vector<CUuid> *m_pSlotUuids;
+
+	std::vector<int> m_vNums;
+	// changes that aren't in the database yet, by slot
+	std::vector<int> m_vChanges;
+	std::vector<bool> m_vDirty;
+	std::vector<COther> m_vOthers;
+	bool m_Dirty;
+
+	COther *FindOther(CUuid Uuid);
+	void Grow(int Slot);
+
+public:
+	CInventory();
+	void Init(const std::vector<CUuid> *pSlotUuids) { m_pSlotUuids = pSlotUuids; }
+
+	// Slot is -1 for items without one
+	int Get(int Slot, CUuid Uuid) const;
+	void Add(int Slot, CUuid Uuid, int Num, bool Save);
+	void Set(int Slot, CUuid Uuid, int Num, bool Save);
+	void Clear();
+
+	// the item got a slot after a datapack was loaded
+	void Adopt(int Slot, CUuid Uuid);
+
+	bool IsDirty() const { return m_Dirty; }
+	// the changes since the last call, as deltas
+	void TakeChanges(std::vector<std::pair<CUuid, int>> *pvChanges);
+
+	// walks the items the client has
+	class CIterator
+	{
+		const CInventory *m_pInventory;
+		int m_Index;
+		std::pair<CUuid, int> m_Current;
+
+		void Skip();
+
+	public:
+		CIterator(const CInventory *pInventory, int Index) :
+			m_pInventory(pInventory), m_Index(Index) { Skip(); }
+
+		const std::pair<CUuid, int> &operator*() const { return m_Current; }
+		const std::pair<CUuid, int> *operator->() const { return &m_Current; }
+		CIterator &operator++() { m_Index++; Skip(); return *this; }
+		bool operator!=(const CIterator &Other) const { return m_Index != Other.m_Index; }
+	};
+
+	CIterator begin() const { return CIterator(this, 0); }
+	CIterator end() const { return CIterator(this, (int) (m_vNums.size() + m_vOthers.size())); }
+};
+
+#endif // LUNARTEE_INVENTORY_H
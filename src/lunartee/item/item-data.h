@@ -31,13 +31,6 @@ public:
     bool m_Makeable;
     CMakeData m_Gives;
     CMakeData m_Needs;
-
-    CItemData &operator=(const CItemData& Other)
-    {
-        mem_copy(this, &Other, sizeof(*this));
-
-        return *this;
-    }
 };
 
 #endif
\ No newline at end of file
@@ -8,7 +8,6 @@
 
 #include <map>
 #include <mutex>
-#include <thread>
 #include <vector>
 
 #include "item.h"
@@ -21,23 +20,160 @@ CItemCore::CItemCore(CGameContext *pGameServer)
     m_pGameServer = pGameServer;
     m_pCraft = new CCraftCore(this);
 
+	for(auto &Inventory : m_aInventories)
+		Inventory.Init(&m_vSlotUuids);
+
 	RegisterMenu();
 }
 
 CUuid CItemCore::GetTypesByUuid(CUuid Uuid)
 {
+	const CItemIndex *pIndex = Index();
+	auto Iter = pIndex->m_TypesByUuid.find(Uuid);
+	if(Iter == pIndex->m_TypesByUuid.end())
+		return Uuid;
+	return Iter->second;
+}
+
+const CItemCore::CItemIndex *CItemCore::Index()
+{
+	if(!m_pIndex)
+		BuildIndex();
+	return m_pIndex.get();
+}
+
+void CItemCore::BuildIndex()
+{
+	std::shared_ptr<CItemIndex> pIndex = std::make_shared<CItemIndex>();
 	for(auto &Type : m_vItems)
 	{
-		if(Type.first == Uuid)
-			return Uuid;
-		
+		pIndex->m_TypesByUuid.emplace(Type.first, Type.first);
 		for(auto &Item : Type.second)
 		{
-			if(Uuid == Item.m_Uuid)
-				return Type.first;
+			// the first item wins like the old search did
+			if(pIndex->m_ItemsByUuid.emplace(Item.m_Uuid, &Item).second && Item.m_Makeable)
+			{
+				int Recipe = (int) pIndex->m_vpRecipes.size();
+				pIndex->m_vpRecipes.push_back(&Item);
+				pIndex->m_RecipesByUuid.emplace(Item.m_Uuid, Recipe);
+				for(auto &Need : Item.m_Needs.m_vDatas)
+				{
+					std::vector<int> &vRecipes = pIndex->m_RecipesByNeed[std::get<0>(Need)];
+					if(vRecipes.empty() || vRecipes.back() != Recipe)
+						vRecipes.push_back(Recipe);
+				}
+			}
+			pIndex->m_TypesByUuid.emplace(Item.m_Uuid, Type.first);
+
+			if(m_ItemSlots.emplace(Item.m_Uuid, (int) m_vSlotUuids.size()).second)
+			{
+				m_vSlotUuids.push_back(Item.m_Uuid);
+				for(auto &Inventory : m_aInventories)
+					Inventory.Adopt(m_vSlotUuids.size() - 1, Item.m_Uuid);
+			}
+		}
+	}
+	m_pIndex = std::move(pIndex);
+
+	for(int i = 0; i < MAX_CLIENTS; i ++)
+		ResetCraftable(i);
+}
+
+bool CItemCore::HasNeeds(int ClientID, const CItemData *pData)
+{
+	for(auto &Need : pData->m_Needs.m_vDatas)
+	{
+		if(GetInvItemNum(std::get<0>(Need), ClientID) < std::get<1>(Need))
+			return false;
+	}
+	return true;
+}
+
+void CItemCore::UpdateCraftable(int ClientID, CUuid Uuid)
+{
+	// only the recipes that need the item can change
+	const CItemIndex *pIndex = Index();
+	auto Iter = pIndex->m_RecipesByNeed.find(Uuid);
+	if(Iter == pIndex->m_RecipesByNeed.end())
+		return;
+
+	for(int Recipe : Iter->second)
+		m_aCraftable[ClientID][Recipe] = HasNeeds(ClientID, pIndex->m_vpRecipes[Recipe]);
+}
+
+void CItemCore::ResetCraftable(int ClientID)
+{
+	const CItemIndex *pIndex = m_pIndex.get();
+	m_aCraftable[ClientID].assign(pIndex ? pIndex->m_vpRecipes.size() : 0, false);
+	if(!pIndex)
+		return;
+
+	for(unsigned Recipe = 0; Recipe < pIndex->m_vpRecipes.size(); Recipe ++)
+		m_aCraftable[ClientID][Recipe] = HasNeeds(ClientID, pIndex->m_vpRecipes[Recipe]);
+}
+
+bool CItemCore::IsCraftable(int ClientID, CUuid Uuid)
+{
+	const CItemIndex *pIndex = Index();
+	auto Iter = pIndex->m_RecipesByUuid.find(Uuid);
+	if(Iter != pIndex->m_RecipesByUuid.end())
+		return m_aCraftable[ClientID][Iter->second];
+
+	CItemData *pData = GetItemData(Uuid);
+	return pData && HasNeeds(ClientID, pData);
+}
+
+CInvTransaction::CInvTransaction(CItemCore *pItem, int ClientID)
+{
+	m_pItem = pItem;
+	m_ClientID = ClientID;
+}
+
+void CInvTransaction::Add(CUuid Uuid, int Num, bool SendChat)
+{
+	m_vChanges.push_back({Uuid, Num, SendChat});
+}
+
+bool CInvTransaction::Commit()
+{
+	// check every item once with all its changes
+	for(unsigned i = 0; i < m_vChanges.size(); i ++)
+	{
+		int Change = 0;
+		bool Seen = false;
+		for(unsigned j = 0; j < m_vChanges.size(); j ++)
+		{
+			if(m_vChanges[j].m_Uuid != m_vChanges[i].m_Uuid)
+				continue;
+			if(j < i)
+			{
+				Seen = true;
+				break;
+			}
+			Change += m_vChanges[j].m_Num;
 		}
+
+		if(!Seen && Change < 0 && m_pItem->GetInvItemNum(m_vChanges[i].m_Uuid, m_ClientID) + Change < 0)
+			return false;
 	}
-	return Uuid;
+
+	// saved together with the next tick
+	for(auto &Change : m_vChanges)
+		m_pItem->AddInvItemNum(Change.m_Uuid, Change.m_Num, m_ClientID, true, Change.m_SendChat);
+	m_vChanges.clear();
+	return true;
+}
+
+int CItemCore::GetItemWeapon(CUuid Uuid) const
+{
+	auto Iter = m_WeaponsByItem.find(Uuid);
+	return Iter == m_WeaponsByItem.end() ? -1 : Iter->second;
+}
+
+int CItemCore::ItemSlot(CUuid Uuid) const
+{
+	auto Iter = m_ItemSlots.find(Uuid);
+	return Iter == m_ItemSlots.end() ? -1 : Iter->second;
 }
 
 void CItemCore::ReadItemJson(std::string FileBuffer, std::string ItemType, class CDatapack *pDatapack)
@@ -45,6 +181,9 @@ void CItemCore::ReadItemJson(std::string FileBuffer, std::string ItemType, class
 	// parse json data
 	nlohmann::json Item = nlohmann::json::parse(FileBuffer);
 
+	// the vectors move, the index is built again when it is used
+	m_pIndex.reset();
+
 	CUuid TypeUuid = CalculateUuid(pDatapack, ItemType.c_str());
 	if(!m_vItems.count(TypeUuid))
 	{
@@ -91,10 +230,32 @@ void CItemCore::ReadItemJson(std::string FileBuffer, std::string ItemType, class
 	}
 }
 
+bool CItemCore::MenuSyncing(int ClientID, const char *pPageName)
+{
+	if(!IsInvSyncing(ClientID))
+		return false;
+
+	std::vector<CMenuOption> Options;
+	Options.push_back(CMenuOption(_("Your items are loading, please wait"), 0, "# {STR}"));
+	Menu()->UpdateMenu(ClientID, Options, pPageName);
+	return true;
+}
+
 void CItemCore::MenuCraft(int ClientID, const char* pCmd, const char* pReason, void *pUserData)
 {
 	CItemCore *pThis = (CItemCore *) pUserData;
 
+	if(pThis->MenuSyncing(ClientID, "CRAFT"))
+		return;
+
+	// who sells a needed item
+	if(str_startswith(pCmd, "SELLS"))
+	{
+		pThis->Menu()->GetMenuPage("TRADE")->m_pfnCallback(ClientID, pCmd, pReason, 
+			pThis->Menu()->GetMenuPage("TRADE")->m_pUserData);
+		return;
+	}
+
 	const char* pSelect;
 	CUuid Uuid;
 	pSelect = "";
@@ -126,7 +287,7 @@ void CItemCore::MenuCraft(int ClientID, const char* pCmd, const char* pReason, v
 	char aCmd[VOTE_CMD_LENGTH];
 	char aCmdCraft[VOTE_CMD_LENGTH];
 
-	for(auto Type : pThis->m_vItems)
+	for(const auto &Type : pThis->m_vItems)
 	{
 		char aUuidStr[UUID_MAXSTRSIZE];	
 		FormatUuid(Type.first, aUuidStr, sizeof(aUuidStr));
@@ -134,12 +295,12 @@ void CItemCore::MenuCraft(int ClientID, const char* pCmd, const char* pReason, v
 		str_format(aCmd, sizeof(aCmd), "LIST %s", aUuidStr);
 		if(Uuid == Type.first)
 		{
-			Options.push_back(CMenuOption(pThis->Menu()->Localize(Type.first), aCmd, "= {STR} ▲"));
+			Options.push_back(CMenuOption(pThis->Menu()->Localize(ClientID, Type.first), aCmd, "= {STR} ▲"));
 			continue;
 		}
 		else
 		{
-			Options.push_back(CMenuOption(pThis->Menu()->Localize(Type.first), aCmd, "= {STR} ▼"));
+			Options.push_back(CMenuOption(pThis->Menu()->Localize(ClientID, Type.first), aCmd, "= {STR} ▼"));
 		}
 
 		for(auto &Item : Type.second)
@@ -152,30 +313,36 @@ void CItemCore::MenuCraft(int ClientID, const char* pCmd, const char* pReason, v
 			str_format(aCmd, sizeof(aCmd), "LIST %s", aUuidStr);
 			str_format(aCmdCraft, sizeof(aCmdCraft), "CRAFT %s", aUuidStr);
 
+			bool Craftable = pThis->IsCraftable(ClientID, Item.m_Uuid);
 			if(str_comp(pSelect, aUuidStr) == 0)
 			{
-				Options.push_back(CMenuOption(pThis->Menu()->Localize(Item.m_Uuid), aCmd, "* {STR} ▼"));
+				Options.push_back(CMenuOption(pThis->Menu()->Localize(ClientID, Item.m_Uuid), aCmd, Craftable ? "* {STR} ✔ ▼" : "* {STR} ▼"));
 				Options.push_back(CMenuOption(_("Requires"), aCmd, "- {STR}:"));
 				
 				char aBuf[VOTE_DESC_LENGTH];
+				char aCmdSells[VOTE_CMD_LENGTH];
 				for(auto Require : Item.m_Needs.m_vDatas)
 				{
 					str_format(aBuf, sizeof(aBuf), "%s x%d (%d)", 
-						pThis->Menu()->Localize(std::get<0>(Require)).c_str(),
+						pThis->Menu()->Localize(ClientID, std::get<0>(Require)).c_str(),
 						std::get<1>(Require),
 						pThis->GetInvItemNum(std::get<0>(Require), ClientID));
 
-					Options.push_back(CMenuOption(aBuf, aCmd, "- {STR}"));
+					char aNeedStr[UUID_MAXSTRSIZE];
+					FormatUuid(std::get<0>(Require), aNeedStr, sizeof(aNeedStr));
+					str_format(aCmdSells, sizeof(aCmdSells), "SELLS %s", aNeedStr);
+
+					Options.push_back(CMenuOption(aBuf, aCmdSells, "- {STR}"));
 				}
 
 				str_format(aBuf, sizeof(aBuf), "%s %s",
-					pThis->Menu()->Localize(_("Craft")),
-					pThis->Menu()->Localize(Item.m_Uuid).c_str());
+					pThis->Menu()->Localize(ClientID, _("Craft")),
+					pThis->Menu()->Localize(ClientID, Item.m_Uuid).c_str());
 				Options.push_back(CMenuOption(aBuf, aCmdCraft, "@ {STR}"));
 				Options.push_back(CMenuOption("", 0, "{STR}"));
 			}
 			else 
-				Options.push_back(CMenuOption(pThis->Menu()->Localize(Item.m_Uuid), aCmd, "* {STR} ▲"));
+				Options.push_back(CMenuOption(pThis->Menu()->Localize(ClientID, Item.m_Uuid), aCmd, Craftable ? "* {STR} ✔ ▲" : "* {STR} ▲"));
 		}
 		Options.push_back(CMenuOption("", 0, "{STR}"));
 	}
@@ -187,14 +354,17 @@ void CItemCore::MenuInventory(int ClientID, const char* pCmd, const char* pReaso
 {
 	CItemCore *pThis = (CItemCore *) pUserData;
 
+	if(pThis->MenuSyncing(ClientID, "INVENTORY"))
+		return;
+
 	std::vector<CMenuOption> Options;
 
 	Options.push_back(CMenuOption(_("Inventory"), 0, "# {STR}"));
 
 	char aBuf[128];
-	for(auto& Item : *(pThis->GetInventory(ClientID)))
+	for(const auto& Item : *(pThis->GetInventory(ClientID)))
 	{
-		str_format(aBuf, sizeof(aBuf), "%s x%d", pThis->Menu()->Localize(Item.first).c_str(), Item.second);
+		str_format(aBuf, sizeof(aBuf), "%s x%d", pThis->Menu()->Localize(ClientID, Item.first).c_str(), Item.second);
 		Options.push_back(CMenuOption(aBuf, "SHOW", "## {STR}"));
 	}
 
@@ -224,46 +394,36 @@ void CItemCore::InitWeapon(std::string Buffer, CDatapack *pDatapack)
 			}
 		}
 	}
+
+	m_WeaponsByItem.clear();
+	for(int i = 0; i < NUM_LUNARTEE_WEAPONS; i ++)
+		m_WeaponsByItem.emplace(g_Weapons.m_aWeapons[i]->GetItemUuid(), i);
 }
 
 CItemData *CItemCore::GetItemData(CUuid Uuid)
 {
-    CItemData *pData = nullptr;
-	
-	for(auto &Type : m_vItems)
-	{
-		for(auto &Item : Type.second)
-		{
-			if(Item.m_Uuid == Uuid)
-				return &Item;
-		}
-	}
-
-	return pData;
+	const CItemIndex *pIndex = Index();
+	auto Iter = pIndex->m_ItemsByUuid.find(Uuid);
+	if(Iter == pIndex->m_ItemsByUuid.end())
+		return nullptr;
+	return Iter->second;
 }
 
-std::map<CUuid, int> *CItemCore::GetInventory(int ClientID)
+CInventory *CItemCore::GetInventory(int ClientID)
 {
 	return &m_aInventories[ClientID];
 }
 
 int CItemCore::GetInvItemNum(CUuid Uuid, int ClientID)
 {
-	if(!m_aInventories[ClientID].count(Uuid))
-		return 0;
-	return m_aInventories[ClientID][Uuid];
+	return m_aInventories[ClientID].Get(ItemSlot(Uuid), Uuid);
 }
 
 void CItemCore::AddInvItemNum(CUuid Uuid, int Num, int ClientID, bool Database, bool SendChat)
 {
-	if(!m_aInventories[ClientID].count(Uuid))
-	{
-		m_aInventories[ClientID][Uuid] = Num;
-	}
-	else
-	{
-		m_aInventories[ClientID][Uuid] += Num;
-	}
+	// saved with the other changes of the tick
+	m_aInventories[ClientID].Add(ItemSlot(Uuid), Uuid, Num, Database);
+	UpdateCraftable(ClientID, Uuid);
 
 	if(SendChat)
 	{
@@ -276,209 +436,141 @@ void CItemCore::AddInvItemNum(CUuid Uuid, int Num, int ClientID, bool Database,
 			GameServer()->SendChatTarget_Localization(ClientID, _("You lost {UUID} x{INT}"), Uuid, -Num);
 		}
 	}
-
-	if(Database)
-	{
-		AddInvItemNumThread(Uuid, Num, ClientID);
-	}
 }
 
 void CItemCore::SetInvItemNum(CUuid Uuid, int Num, int ClientID, bool Database)
 {
-	m_aInventories[ClientID][Uuid] = Num;
-
-	if(Database)
-	{
-		SetInvItemNumThread(Uuid, m_aInventories[ClientID][Uuid], ClientID);
-	}
+	m_aInventories[ClientID].Set(ItemSlot(Uuid), Uuid, Num, Database);
+	UpdateCraftable(ClientID, Uuid);
 }
 
-static std::mutex s_ItemMutex;
-void CItemCore::AddInvItemNumThread(CUuid Uuid, int Num, int ClientID)
+void CItemCore::Tick()
 {
-	if(Num == 0)
-		return;
+	FinishSyncJobs();
 
-	if(!GameServer()->m_apPlayers[ClientID])
+	for(int i = 0; i < MAX_CLIENTS; i ++)
 	{
-		return;
+		// the rows read by a sync must not have the changes saved after it
+		if(m_aInventories[i].IsDirty() && !m_apSyncJobs[i])
+			SaveInv(i);
 	}
+}
 
-	std::thread Thread([this, Uuid, Num, ClientID]()
+void CItemCore::CSaveJob::Run()
+{
+	// one statement, so all changes are in the database or none:
+	// rows that exist are updated, the others inserted
+	std::string Buffer;
+	Buffer.append("WITH v (Uuid, Num) AS (VALUES ");
+	for(unsigned i = 0; i < m_vChanges.size(); i ++)
 	{
-		auto pOwner = GameServer()->GetPlayer(ClientID);
-		if(!pOwner)
-			return;
-		int UserID = pOwner->GetUserID();
-
 		char aUuidStr[UUID_MAXSTRSIZE];	
-		FormatUuid(Uuid, aUuidStr, sizeof(aUuidStr));
+		FormatUuid(m_vChanges[i].first, aUuidStr, sizeof(aUuidStr));
 
-		std::string Buffer;
-
-		Buffer.append("WHERE OwnerID=");
-		Buffer.append(std::to_string(UserID));
-		Buffer.append(" AND ");
-		Buffer.append("Uuid='");
+		if(i)
+			Buffer.append(", ");
+		Buffer.append("('");
 		Buffer.append(aUuidStr);
-		Buffer.append("';");
-
-		s_ItemMutex.lock();
-
-		SqlResult *pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_itemdata",
-			Buffer.c_str(), "*");
-
-		if(!pSqlResult)
-		{
-			return;
-		}
-
-		if(!pSqlResult->size())
-		{
-			Buffer.clear();
-			Buffer.append("(OwnerID, Uuid, Num) VALUES (");
-			Buffer.append(std::to_string(UserID));
-			Buffer.append(", '");
-			Buffer.append(aUuidStr);
-			Buffer.append("', ");
-			Buffer.append(std::to_string(Num));
-			Buffer.append(");");
-
-			Sql()->Execute<SqlType::INSERT>("lt_itemdata", Buffer.c_str());
-		}
-		else
-		{
-			int ID = pSqlResult->begin()["ID"].as<int>();
-
-			Buffer.clear();
-			Buffer.append("Num = Num");
-			if(Num > 0)
-				Buffer.append("+");
-			Buffer.append(std::to_string(Num));
-			Buffer.append(" WHERE ID = ");
-			Buffer.append(std::to_string(ID));
-			Buffer.append(";");
-
-			Sql()->Execute<SqlType::UPDATE>("lt_itemdata", Buffer.c_str());
-		}
-
-		s_ItemMutex.unlock();
-	});
-	Thread.detach();
-	return;
+		Buffer.append("', ");
+		Buffer.append(std::to_string(m_vChanges[i].second));
+		Buffer.append(")");
+	}
+	// only the first row of an item gets the change, a sync sums the duplicates
+	Buffer.append("), u AS (UPDATE lt_itemdata t SET Num = t.Num + v.Num FROM v WHERE t.ID IN (SELECT min(ID) FROM lt_itemdata WHERE OwnerID = ");
+	Buffer.append(std::to_string(m_UserID));
+	Buffer.append(" GROUP BY Uuid) AND t.Uuid = v.Uuid RETURNING t.Uuid) ");
+	Buffer.append("INSERT INTO lt_itemdata (OwnerID, Uuid, Num) SELECT ");
+	Buffer.append(std::to_string(m_UserID));
+	Buffer.append(", v.Uuid, v.Num FROM v WHERE v.Uuid NOT IN (SELECT Uuid FROM u);");
+
+	if(!Sql()->Execute(Buffer.c_str()))
+		log_error("item", "failed to save %d item changes of user %d", (int) m_vChanges.size(), m_UserID);
 }
 
-void CItemCore::SetInvItemNumThread(CUuid Uuid, int Num, int ClientID)
+void CItemCore::SaveInv(int ClientID)
 {
-	if(!GameServer()->m_apPlayers[ClientID])
-	{
-		return;
-	}
-
-	std::thread Thread([this, Uuid, Num, ClientID]()
-	{
-		auto pOwner = GameServer()->GetPlayer(ClientID);
-		if(!pOwner)
-			return;
-		int UserID = pOwner->GetUserID();
-
-		char aUuidStr[UUID_MAXSTRSIZE];	
-		FormatUuid(Uuid, aUuidStr, sizeof(aUuidStr));
-
-		std::string Buffer;
-
-		Buffer.append("WHERE OwnerID=");
-		Buffer.append(std::to_string(UserID));
-		Buffer.append(" AND ");
-		Buffer.append("Uuid='");
-		Buffer.append(aUuidStr);
-		Buffer.append("';");
+	std::vector<std::pair<CUuid, int>> vChanges;
+	m_aInventories[ClientID].TakeChanges(&vChanges);
 
-		SqlResult *pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_itemdata",
-			Buffer.c_str(), "*");
+	// the items of guests aren't kept
+	CPlayer *pOwner = GameServer()->m_apPlayers[ClientID];
+	if(vChanges.empty() || !pOwner || !pOwner->IsLogin())
+		return;
 
-		if(!pSqlResult)
-		{
-			return;
-		}
+	Sql()->AddJob(std::make_shared<CSaveJob>(pOwner->GetUserID(), std::move(vChanges)));
+}
 
-		s_ItemMutex.lock();
+void CItemCore::CSyncJob::Run()
+{
+	std::string Buffer;
 
-		if(!pSqlResult->size())
-		{
-			Buffer.clear();
-			Buffer.append("(OwnerID, Uuid, Num) VALUES (");
-			Buffer.append(std::to_string(UserID));
-			Buffer.append(", '");
-			Buffer.append(aUuidStr);
-			Buffer.append("', ");
-			Buffer.append(std::to_string(Num));
-			Buffer.append(");");
-
-			Sql()->Execute<SqlType::INSERT>("lt_itemdata", Buffer.c_str());
-		}else
-		{
-			int ID = pSqlResult->begin()["ID"].as<int>();
+	Buffer.append("WHERE OwnerID=");
+	Buffer.append(std::to_string(m_UserID));
 
-			Buffer.clear();
-			Buffer.append("Num = ");
-			Buffer.append(std::to_string(Num));
-			Buffer.append(" WHERE ID = ");
-			Buffer.append(std::to_string(ID));
-			Buffer.append(";");
+	std::unique_ptr<SqlResult> pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_itemdata",
+		Buffer.c_str(), "*");
 
-			Sql()->Execute<SqlType::UPDATE>("lt_itemdata", Buffer.c_str());
-		}
+	if(!pSqlResult)
+		return;
 
-		s_ItemMutex.unlock();
-	});
-	Thread.detach();
-	return;
+	m_vRows.reserve(pSqlResult->size());
+	for(SqlResult::const_iterator Iter = pSqlResult->begin(); Iter != pSqlResult->end(); ++ Iter)
+	{
+		CUuid Uuid;
+		if(ParseUuid(&Uuid, Iter["Uuid"].as<std::string>().c_str()))
+			continue;
+		m_vRows.emplace_back(Uuid, Iter["Num"].as<int>());
+	}
+	m_Success = true;
 }
 
 void CItemCore::SyncInvItem(int ClientID)
 {
-	if(!GameServer()->m_apPlayers[ClientID])
-	{
+	CPlayer *pOwner = GameServer()->m_apPlayers[ClientID];
+	if(!pOwner || !pOwner->IsLogin())
 		return;
-	}
 
-	std::thread Thread([this, ClientID]()
-	{
-		auto pOwner = GameServer()->m_apPlayers[ClientID];
-		if(!pOwner)
-			return;
-		int UserID = pOwner->GetUserID();
-
-		std::string Buffer;
+	// the account's items replace what the guest had, changes from now on
+	// are kept and saved once the rows are in
+	m_aInventories[ClientID].Clear();
+	ResetCraftable(ClientID);
 
-		Buffer.append("WHERE OwnerID=");
-		Buffer.append(std::to_string(UserID));
+	// a sync still running for the client is dropped, its rows may miss the
+	// saves added since
+	m_apSyncJobs[ClientID] = std::make_shared<CSyncJob>(ClientID, pOwner->GetUserID());
+	// after the saves that were added before
+	Sql()->AddJob(m_apSyncJobs[ClientID]);
+}
 
-		SqlResult *pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_itemdata",
-			Buffer.c_str(), "*");
+void CItemCore::FinishSyncJobs()
+{
+	for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID ++)
+	{
+		CSyncJob *pJob = m_apSyncJobs[ClientID].get();
+		if(!pJob || pJob->Status() != IJob::STATE_DONE)
+			continue;
 
-		if(!pSqlResult)
+		// the client may have left or logged into another account since
+		CPlayer *pOwner = GameServer()->m_apPlayers[ClientID];
+		if(pOwner && pOwner->GetUserID() == pJob->m_UserID)
 		{
-			return;
-		}
+			if(!pJob->m_Success)
+				log_error("item", "failed to load the items of user %d", pJob->m_UserID);
 
-		if(pSqlResult->size())
-		{
-			for(SqlResult::const_iterator Iter = pSqlResult->begin(); Iter != pSqlResult->end(); ++ Iter)
-			{
-				CUuid Uuid;
-				if(ParseUuid(&Uuid, Iter["Uuid"].as<std::string>().c_str()))
-					continue;
-				SetInvItemNum(Uuid, Iter["Num"].as<int>(), ClientID, false);
-			}
+			for(auto &Row : pJob->m_vRows)
+				m_aInventories[ClientID].Add(ItemSlot(Row.first), Row.first, Row.second, false);
+			ResetCraftable(ClientID);
 		}
-	});
-	Thread.detach();
-	return;
+		m_apSyncJobs[ClientID] = nullptr;
+	}
 }
 
 void CItemCore::ClearInv(int ClientID, bool Database)
 {
-	m_aInventories[ClientID].clear();
+	// the changes of the last tick, a running sync is dropped with them
+	if(Database)
+		SaveInv(ClientID);
+	m_aInventories[ClientID].Clear();
+	ResetCraftable(ClientID);
+	m_apSyncJobs[ClientID] = nullptr;
 }
\ No newline at end of file
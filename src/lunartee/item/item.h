@@ -2,8 +2,13 @@
 #define LUNARTEE_ITEM_H
 
 #include <map>
+#include <memory>
+#include <unordered_map>
 
 #include <base/uuid.h>
+#include <engine/shared/jobs.h>
+
+#include "inventory.h"
 #include "item-data.h"
 
 class CItemCore
@@ -14,10 +19,72 @@ class CItemCore
 
     class CCraftCore *m_pCraft;
 
-    std::map<CUuid, int> m_aInventories[MAX_CLIENTS];
+    CInventory m_aInventories[MAX_CLIENTS];
+
+    // the dense index of each item for the inventories, only grows
+    std::unordered_map<CUuid, int> m_ItemSlots;
+    std::vector<CUuid> m_vSlotUuids;
+    int ItemSlot(CUuid Uuid) const;
+
+    // reads the items of a user on the job threads, the rows are applied
+    // on the game thread by Tick
+    class CSyncJob : public IJob
+    {
+        void Run() override;
+
+    public:
+        CSyncJob(int ClientID, int UserID) :
+            m_ClientID(ClientID), m_UserID(UserID), m_Success(false) {}
+
+        const int m_ClientID;
+        const int m_UserID;
+        bool m_Success;
+        std::vector<std::pair<CUuid, int>> m_vRows;
+    };
+
+    // writes the changes of an inventory as relative updates
+    class CSaveJob : public IJob
+    {
+        void Run() override;
+
+    public:
+        CSaveJob(int UserID, std::vector<std::pair<CUuid, int>> vChanges) :
+            m_UserID(UserID), m_vChanges(std::move(vChanges)) {}
+
+        const int m_UserID;
+        const std::vector<std::pair<CUuid, int>> m_vChanges;
+    };
+
+    // the latest sync of each client, the results of older ones are dropped
+    std::shared_ptr<CSyncJob> m_apSyncJobs[MAX_CLIENTS];
+    void FinishSyncJobs();
 
     int m_ItemTypeNum;
 
+    // built from m_vItems once they are read, replaced whole on reload
+    struct CItemIndex
+    {
+        std::unordered_map<CUuid, CItemData *> m_ItemsByUuid;
+        // the type of each item, and each type to itself
+        std::unordered_map<CUuid, CUuid> m_TypesByUuid;
+
+        // the makeable items, and the ones each item is needed by
+        std::vector<const CItemData *> m_vpRecipes;
+        std::unordered_map<CUuid, int> m_RecipesByUuid;
+        std::unordered_map<CUuid, std::vector<int>> m_RecipesByNeed;
+    };
+    std::shared_ptr<const CItemIndex> m_pIndex;
+    const CItemIndex *Index();
+
+    // by recipe, kept up to date with the inventory
+    std::vector<bool> m_aCraftable[MAX_CLIENTS];
+    bool HasNeeds(int ClientID, const CItemData *pData);
+    void UpdateCraftable(int ClientID, CUuid Uuid);
+    void ResetCraftable(int ClientID);
+
+    // the weapon each item gives, from weapons.json
+    std::unordered_map<CUuid, int> m_WeaponsByItem;
+
     CUuid GetTypesByUuid(CUuid Uuid);
 
     static void MenuCraft(int ClientID, const char* pCmd, const char* pReason, void *pUserData);
@@ -35,16 +102,52 @@ public:
 
     void InitWeapon(std::string Buffer, class CDatapack *pDatapack);
     void ReadItemJson(std::string FileBuffer, std::string ItemType, class CDatapack *pDatapack);
+    // call after the items of a datapack were read
+    void BuildIndex();
 
     CItemData *GetItemData(CUuid Uuid);
-    std::map<CUuid, int> *GetInventory(int ClientID);
+    // the client has the items the item needs
+    bool IsCraftable(int ClientID, CUuid Uuid);
+    // the weapon of the item, -1 if it is none
+    int GetItemWeapon(CUuid Uuid) const;
+    CInventory *GetInventory(int ClientID);
     int GetInvItemNum(CUuid Uuid, int ClientID);
     void AddInvItemNum(CUuid Uuid, int Num, int ClientID, bool Database = true, bool SendChat = false);
     void SetInvItemNum(CUuid Uuid, int Num, int ClientID, bool Database = true);
-    void AddInvItemNumThread(CUuid Uuid, int Num, int ClientID);
-    void SetInvItemNumThread(CUuid Uuid, int Num, int ClientID);
+    // writes the changed items of the client to the database
+    void SaveInv(int ClientID);
+    // loads the items of the account after a login
     void SyncInvItem(int ClientID);
+    // the items of the account aren't there yet, craft and trade have to wait
+    bool IsInvSyncing(int ClientID) const { return m_apSyncJobs[ClientID] != nullptr; }
+    // shows the page as loading while the items are synced
+    bool MenuSyncing(int ClientID, const char *pPageName);
+    void Tick();
+    // Database saves the changes that aren't written yet, else they are lost
     void ClearInv(int ClientID, bool Database = true);
 };
 
+// changes of one inventory that are made together or not at all, they are
+// also saved to the database in one statement
+class CInvTransaction
+{
+    struct CChange
+    {
+        CUuid m_Uuid;
+        int m_Num;
+        bool m_SendChat;
+    };
+
+    CItemCore *m_pItem;
+    int m_ClientID;
+    std::vector<CChange> m_vChanges;
+
+public:
+    CInvTransaction(CItemCore *pItem, int ClientID);
+
+    void Add(CUuid Uuid, int Num, bool SendChat = false);
+    // false and nothing changed if an item would go below zero
+    bool Commit();
+};
+
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "localization.h"
 
 #include <engine/external/json/json.hpp>
+#include <engine/server.h>
 #include <engine/shared/config.h>
 #include <engine/storage.h>
 
@@ -10,7 +11,7 @@
 #include <cstdarg>
 
 CLocalization::CLanguage::CLanguage() :
-	m_Loaded(false)
+	m_pTable(nullptr)
 {
 	m_aName[0] = 0;
 	m_aFilename[0] = 0;
@@ -18,7 +19,7 @@ CLocalization::CLanguage::CLanguage() :
 }
 
 CLocalization::CLanguage::CLanguage(const char *pName, const char *pFilename, const char *pParentFilename) :
-	m_Loaded(false)
+	m_pTable(nullptr)
 {
 	str_copy(m_aName, pName, sizeof(m_aName));
 	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
@@ -33,9 +34,12 @@ void CLocalization::CLanguage::SetFlag(const char *pFlag)
 	str_copy(m_aFlag, pFlag, sizeof(m_aFlag));
 }
 
-CLocalization::CLanguage::~CLanguage() = default;
+CLocalization::CLanguage::~CLanguage()
+{
+	delete m_pTable.load();
+}
 
-bool CLocalization::CLanguage::Load(CLocalization* pLocalization, IStorage* pStorage, std::string FileStr, class CDatapack *pDatapack)
+void CLocalization::CLanguage::Load(CTable *pTable, const std::string &FileStr, const CDatapack *pDatapack)
 {
 	char FileLine[512];
 	bool isEndOfFile = false;
@@ -83,88 +87,183 @@ bool CLocalization::CLanguage::Load(CLocalization* pLocalization, IStorage* pSto
 			if(str_length(FileLine) > str_length(MsgStrKey))
 			{
 				std::string Value = FileLine + 3;
-				CUuid Uuid = CalculateUuid(Key.c_str());
 				if(pDatapack)
-				{
-					Uuid = CalculateUuid(pDatapack, Key.c_str());
-				}
-				
-				m_Translations.insert(std::pair(Uuid, Value));
+					pTable->m_UuidTranslations.insert(std::pair(CalculateUuid(pDatapack, Key.c_str()), Value));
+				else
+					pTable->m_Translations.emplace(LocalizeHash(Key.c_str()), CFormatTemplate(Value.c_str()));
 			}
 		}
 	}
+}
+
+const char *CLocalization::CLanguage::Localize(CLocalizeKey Key)
+{	
+	const CFormatTemplate *pTemplate = FindTemplate(Key);
+	return pTemplate ? pTemplate->Text() : nullptr;
+}
+
+const CFormatTemplate *CLocalization::CLanguage::FindTemplate(CLocalizeKey Key)
+{	
+	CTable *pTable = m_pTable.load(std::memory_order_acquire);
+	if(!pTable)
+		return nullptr;
 
-	m_Loaded = true;
+	auto Iter = pTable->m_Translations.find(Key.m_Hash);
+	if(Iter == pTable->m_Translations.end())
+		return nullptr;
 	
-	return true;
+	return &Iter->second;
 }
 
-bool CLocalization::CLanguage::Load(CLocalization* pLocalization, IStorage* pStorage)
+const CFormatTemplate *CLocalization::CLanguage::CompileTemplate(CLocalizeKey Key)
 {
-	// read file data into buffer
-	char aBuf[256];
-	str_format(aBuf, sizeof(aBuf), "./data/server_lang/%s.lang", m_aFilename);
+	auto Iter = m_TemplateCache.find(Key.m_Hash);
+	if(Iter != m_TemplateCache.end())
+		return &Iter->second;
+
+	// texts built at runtime could grow it without end
+	if(m_TemplateCache.size() >= 4096)
+		m_TemplateCache.clear();
+	return &m_TemplateCache.emplace(Key.m_Hash, CFormatTemplate(Key.m_pText)).first->second;
+}
+
+const char *CLocalization::CLanguage::Localize(const CUuid Uuid)
+{	
+	CTable *pTable = m_pTable.load(std::memory_order_acquire);
+	if(!pTable)
+		return nullptr;
+
+	auto Iter = pTable->m_UuidTranslations.find(Uuid);
+	if(Iter == pTable->m_UuidTranslations.end())
+		return nullptr;
 	
-	IOHANDLE File = pStorage->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
+	return Iter->second.c_str();
+}
 
-	bool Success = true;
-	if(File) // this language maybe not a official language
-	{
-		Success = Load(pLocalization, pStorage, io_read_all_str(File));
+CLocalization::CLoadJob::CLoadJob(IStorage *pStorage, std::vector<CLanguage *> vpLanguages, std::vector<CDatapack> vDatapacks) :
+	m_pStorage(pStorage),
+	m_vpLanguages(std::move(vpLanguages)),
+	m_vDatapacks(std::move(vDatapacks))
+{
+}
 
-		io_close(File);
+CLocalization::CLoadJob::~CLoadJob()
+{
+	for(auto &pTable : m_vpOldTables)
+		delete pTable;
+}
+
+void CLocalization::CLoadJob::Run()
+{
+	std::vector<CLanguage::CTable *> vpTables;
+	for(auto &pLanguage : m_vpLanguages)
+	{
+		vpTables.push_back(new CLanguage::CTable());
+
+		// this language maybe not a official language
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "./data/server_lang/%s.lang", pLanguage->GetFilename());
+		void *pData;
+		unsigned Size;
+		if(m_pStorage->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &Size))
+		{
+			CLanguage::Load(vpTables.back(), std::string((const char *) pData, Size));
+			free(pData);
+		}
 	}
 
 	// read datapack languages
-	CUnzip Unzip;
-
-	for(auto& Datapack : Datas()->m_Datapacks)
+	for(auto &Datapack : m_vDatapacks)
 	{
-		if(!(Datapack.m_State&DatapackState::PACKSTATE_ENABLE))
+		CUnzip Unzip;
+		if(!Unzip.OpenFile(Datapack.m_aLocalPath))
 			continue;
-
-		Unzip.OpenFile(Datapack.m_aLocalPath);
 		Unzip.LoadDirFile();
 
-		std::string FileBuffer;
-		char aPath[IO_MAX_PATH_LENGTH];
-		str_format(aPath, sizeof(aPath), "translations/%s.lang", m_aFilename);
-		if(Unzip.UnzipFile(FileBuffer, aPath))
-			Success = Load(pLocalization, pStorage, FileBuffer, &Datapack);
-
-		Unzip.CloseFile();
+		for(unsigned i = 0; i < m_vpLanguages.size(); i++)
+		{
+			std::string FileBuffer;
+			char aPath[IO_MAX_PATH_LENGTH];
+			str_format(aPath, sizeof(aPath), "translations/%s.lang", m_vpLanguages[i]->GetFilename());
+			if(Unzip.UnzipFile(FileBuffer, aPath))
+				CLanguage::Load(vpTables[i], FileBuffer, &Datapack);
+		}
 	}
 
-	dbg_msg("localization", "loaded language '%s'", m_aName);
-
-	return Success;
-}
+	for(unsigned i = 0; i < m_vpLanguages.size(); i++)
+	{
+		CLanguage::CTable *pOld = m_vpLanguages[i]->SwapTable(vpTables[i]);
+		if(pOld)
+			m_vpOldTables.push_back(pOld);
+	}
 
-const char *CLocalization::CLanguage::Localize(const char *pText)
-{	
-	return Localize(CalculateUuid(pText));
-}
-
-const char *CLocalization::CLanguage::Localize(const CUuid Uuid)
-{	
-	if(!m_Translations.count(Uuid))
-		return nullptr;
-	
-	return m_Translations[Uuid].c_str();
+	dbg_msg("localization", "loaded %d languages from %d datapacks", (int) m_vpLanguages.size(), (int) m_vDatapacks.size());
 }
 
 CLocalization::CLocalization(class IStorage* pStorage) :
 	m_pStorage(pStorage),
-	m_pMainLanguage(nullptr)
+	m_pMainLanguage(nullptr),
+	m_ReloadWanted(false)
 {
 }
 
 CLocalization::~CLocalization()
 {
+	// the job holds the languages, the job pool still runs it
+	if(m_pLoadJob)
+	{
+		while(m_pLoadJob->Status() != IJob::STATE_DONE)
+			thread_yield();
+		m_pLoadJob = nullptr;
+	}
+
 	for(auto &pLanguage : m_vpLanguages)
 		delete pLanguage;
 }
 
+void CLocalization::AddLanguage(CLanguage *pLanguage)
+{
+	m_vpLanguages.push_back(pLanguage);
+	m_LanguagesByCode[pLanguage->GetFilename()] = pLanguage;
+}
+
+CLocalization::CLanguage *CLocalization::FindLanguage(const char *pLanguageCode)
+{
+	if(!pLanguageCode)
+		return m_pMainLanguage;
+
+	auto Iter = m_LanguagesByCode.find(pLanguageCode);
+	if(Iter == m_LanguagesByCode.end())
+		return m_pMainLanguage;
+	return Iter->second;
+}
+
+void CLocalization::Update(IServer *pServer)
+{
+	if(m_pLoadJob)
+	{
+		if(m_pLoadJob->Status() != IJob::STATE_DONE)
+			return;
+		// pointers into the tables don't outlive a call on this thread, the old ones can go
+		m_pLoadJob = nullptr;
+	}
+
+	if(!m_ReloadWanted)
+		return;
+	m_ReloadWanted = false;
+
+	// the job gets copies, the datapack list changes on this thread
+	std::vector<CDatapack> vDatapacks;
+	for(auto &Datapack : Datas()->m_Datapacks)
+	{
+		if((Datapack.m_State & PACKSTATE_ENABLE) && Datapack.m_aLocalPath[0] && Datapack.m_aPackageID[0])
+			vDatapacks.push_back(Datapack);
+	}
+
+	m_pLoadJob = std::make_shared<CLoadJob>(Storage(), m_vpLanguages, vDatapacks);
+	pServer->CreateNewTheardJob(m_pLoadJob);
+}
+
 bool CLocalization::InitConfig(int argc, const char ** argv)
 {
 	return true;
@@ -181,7 +280,8 @@ bool CLocalization::Init()
 		return false;
 	// extract data
 	m_pMainLanguage = 0;
-	nlohmann::json rStart = nlohmann::json::parse( (char *) pBuf);
+	nlohmann::json rStart = nlohmann::json::parse((char *) pBuf, (char *) pBuf + Length);
+	free(pBuf);
 	if(rStart.is_array())
 	{
 		for(auto& Current : rStart)
@@ -189,7 +289,7 @@ bool CLocalization::Init()
 			CLanguage *pLanguage = new CLanguage(Current["name"].get<std::string>().c_str(),
 				Current["file"].get<std::string>().c_str(), Current["parent"].empty() ? "" : Current["parent"].get<std::string>().c_str());
 
-			m_vpLanguages.push_back(pLanguage);
+			AddLanguage(pLanguage);
 			
 			pLanguage->SetFlag(Current["flag"].empty() ? "default" : Current["flag"].get<std::string>().c_str());
 
@@ -212,71 +312,41 @@ void CLocalization::LoadDatapack(class CUnzip *pUnzip, std::string Buffer)
 		for(auto& Current : rStart)
 		{
 			CLanguage *pLanguage = nullptr;
-			auto Iter = find_if(m_vpLanguages.begin(), m_vpLanguages.end(), 
-				[Current](CLocalization::CLanguage *a)
-				{
-					return (str_comp(a->GetFilename(), Current["file"].get<std::string>().c_str()) == 0);
-				});
-			if(Iter != m_vpLanguages.end())
+			auto Iter = m_LanguagesByCode.find(Current["file"].get<std::string>());
+			if(Iter != m_LanguagesByCode.end())
 			{
-				pLanguage = *Iter;
+				pLanguage = Iter->second;
 				dbg_msg("localization", "find language '%s' as origin", pLanguage->GetName());
 			}
 			else
 			{
-				m_vpLanguages.push_back(new CLanguage(Current["name"].get<std::string>().c_str(),
-					Current["file"].get<std::string>().c_str(), Current["parent"].empty() ? "" : Current["parent"].get<std::string>().c_str()));
-
-				pLanguage = (* m_vpLanguages.rbegin());
+				pLanguage = new CLanguage(Current["name"].get<std::string>().c_str(),
+					Current["file"].get<std::string>().c_str(), Current["parent"].empty() ? "" : Current["parent"].get<std::string>().c_str());
+				AddLanguage(pLanguage);
 			}
 		}
 	}
 }
 
-const char *CLocalization::LocalizeWithDepth(const char *pLanguageCode, const char *pText, int Depth)
+const char *CLocalization::LocalizeWithDepth(const char *pLanguageCode, CLocalizeKey Key, int Depth)
 {
-	CLanguage* pLanguage = m_pMainLanguage;	
-	if(pLanguageCode)
-	{
-		for(auto ipLanguage : m_vpLanguages)
-		{
-			if(str_comp(ipLanguage->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = ipLanguage;
-				break;
-			}
-		}
-	}
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
 	
 	if(!pLanguage)
-		return pText;
-	
-	if(!pLanguage->IsLoaded())
-		pLanguage->Load(this, Storage());
+		return Key.m_pText;
 	
-	const char *pResult = pLanguage->Localize(pText);
+	const char *pResult = pLanguage->Localize(Key);
 	if(pResult)
 		return pResult;
 	else if(pLanguage->GetParentFilename()[0] && str_comp(pLanguage->GetFilename(), pLanguage->GetParentFilename()) && Depth < 4)
-		return LocalizeWithDepth(pLanguage->GetParentFilename(), pText, Depth+1);
+		return LocalizeWithDepth(pLanguage->GetParentFilename(), Key, Depth+1);
 	else
-		return pText;
+		return Key.m_pText;
 }
 
 std::string CLocalization::LocalizeWithDepth(const char *pLanguageCode, CUuid Uuid, int Depth)
 {
-	CLanguage* pLanguage = m_pMainLanguage;	
-	if(pLanguageCode)
-	{
-		for(auto ipLanguage : m_vpLanguages)
-		{
-			if(str_comp(ipLanguage->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = ipLanguage;
-				break;
-			}
-		}
-	}
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
 
 	char aText[UUID_MAXSTRSIZE];
 	FormatUuid(Uuid, aText, sizeof(aText));
@@ -284,9 +354,6 @@ std::string CLocalization::LocalizeWithDepth(const char *pLanguageCode, CUuid Uu
 	if(!pLanguage)
 		return std::string(aText);
 	
-	if(!pLanguage->IsLoaded())
-		pLanguage->Load(this, Storage());
-	
 	const char *pResult = pLanguage->Localize(Uuid);
 	if(pResult)
 		return pResult;
@@ -296,9 +363,9 @@ std::string CLocalization::LocalizeWithDepth(const char *pLanguageCode, CUuid Uu
 		return std::string(aText);
 }
 
-const char *CLocalization::Localize(const char *pLanguageCode, const char *pText)
+const char *CLocalization::Localize(const char *pLanguageCode, CLocalizeKey Key)
 {
-	return LocalizeWithDepth(pLanguageCode, pText, 0);
+	return LocalizeWithDepth(pLanguageCode, Key, 0);
 }
 
 std::string CLocalization::Localize(const char *pLanguageCode, CUuid Uuid)
@@ -306,91 +373,130 @@ std::string CLocalization::Localize(const char *pLanguageCode, CUuid Uuid)
 	return LocalizeWithDepth(pLanguageCode, Uuid, 0);
 }
 
-void CLocalization::Format_V(std::string& Buffer, const char *pLanguageCode, const char *pText, va_list VarArgs)
+void CFormatTemplate::Compile(const char *pText)
 {
-	CLanguage* pLanguage = m_pMainLanguage;	
-	if(pLanguageCode)
+	m_Text = pText;
+	m_vSegments.clear();
+	m_SizeHint = 0;
+
+	int Iter = 0;
+	int LiteralStart = 0;
+	while(pText[Iter])
 	{
-		for(auto ipLanguage : m_vpLanguages)
+		if(pText[Iter] != '{')
 		{
-			if(str_comp(ipLanguage->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = ipLanguage;
-				break;
-			}
+			Iter ++;
+			continue;
+		}
+
+		if(Iter > LiteralStart)
+		{
+			m_vSegments.push_back({SEGMENT_LITERAL, LiteralStart, Iter - LiteralStart});
+			m_SizeHint += Iter - LiteralStart;
 		}
+
+		// an unclosed placeholder drops the rest of the text, the character
+		// after '{' never closes it
+		const char *pName = pText + Iter + 1;
+		const char *pEnd = pName[0] ? str_find(pText + str_utf8_forward(pText, Iter + 1), "}") : nullptr;
+		if(!pEnd)
+		{
+			LiteralStart = Iter = str_length(pText);
+			break;
+		}
+
+		int Type = -1;
+		if(str_comp_num("UUID", pName, 4) == 0)
+			Type = SEGMENT_UUID;
+		else if(str_comp_num("STR", pName, 3) == 0)
+			Type = SEGMENT_STR;
+		else if(str_comp_num("LSTR", pName, 4) == 0)
+			Type = SEGMENT_LSTR;
+		else if(str_comp_num("INT", pName, 3) == 0)
+			Type = SEGMENT_INT;
+		else if(str_comp_num("NUM", pName, 3) == 0)
+			Type = SEGMENT_NUM;
+
+		// unknown placeholders print nothing and take no argument
+		if(Type != -1)
+		{
+			m_vSegments.push_back({Type, 0, 0});
+			m_SizeHint += 16;
+		}
+
+		LiteralStart = Iter = pEnd + 1 - pText;
 	}
-	if(!pLanguage)
+
+	if(Iter > LiteralStart)
 	{
-		Buffer.append(pText);
-		return;
+		m_vSegments.push_back({SEGMENT_LITERAL, LiteralStart, Iter - LiteralStart});
+		m_SizeHint += Iter - LiteralStart;
 	}
-	int Iter = 0;
-	int FormatStart = -1;
+}
 
+void CLocalization::FormatTemplate(std::string& Buffer, CLanguage *pLanguage, const CFormatTemplate *pTemplate, va_list VarArgs)
+{
 	va_list VarArgsIter;
 	va_copy(VarArgsIter, VarArgs);
 
-	while(pText[Iter])
+	Buffer.reserve(Buffer.size() + pTemplate->SizeHint());
+	const char *pText = pTemplate->Text();
+	for(const auto &Segment : pTemplate->Segments())
 	{
-		if(FormatStart != -1)
+		switch(Segment.m_Type)
 		{
-			if(pText[Iter] != '}')
-			{
-				Iter = str_utf8_forward(pText, Iter);
-				continue;
-			}
-			
-			if(str_comp_num("UUID", pText + FormatStart, 4) == 0) // uuid
-			{
-				const char* pStr = pLanguage->Localize(va_arg(VarArgsIter, CUuid));
-				if(pStr)
-					Buffer += pStr;
-				else
-				{
-					char aText[UUID_MAXSTRSIZE];
-					FormatUuid(va_arg(VarArgsIter, CUuid), aText, sizeof(aText));
-					Buffer += aText;
-				}
-			}
-			else if(str_comp_num("STR", pText + FormatStart, 3) == 0) // string
-			{
-				Buffer += va_arg(VarArgsIter, const char *);
-			}
-			else if(str_comp_num("LSTR", pText + FormatStart, 4) == 0) // Translate string
-			{
-				const char* pStr = va_arg(VarArgsIter, const char *);
-				const char* pTranslateStr = pLanguage->Localize(pStr);
-				if(!pTranslateStr || !pTranslateStr[0])
-					Buffer += pStr;
-				else 
-					Buffer += pTranslateStr;
-			}
-			else if(str_comp_num("INT", pText + FormatStart, 3) == 0) // int
-			{
-				Buffer += std::to_string(va_arg(VarArgsIter, int));
-			}
-			else if(str_comp_num("NUM", pText + FormatStart, 3) == 0) // number (double)
+		case CFormatTemplate::SEGMENT_LITERAL:
+			Buffer.append(pText + Segment.m_Start, Segment.m_Length);
+			break;
+		case CFormatTemplate::SEGMENT_UUID:
+		{
+			CUuid Uuid = va_arg(VarArgsIter, CUuid);
+			const char* pStr = pLanguage->Localize(Uuid);
+			if(pStr)
+				Buffer += pStr;
+			else
 			{
-				Buffer += std::to_string(va_arg(VarArgsIter, double));
+				char aText[UUID_MAXSTRSIZE];
+				FormatUuid(Uuid, aText, sizeof(aText));
+				Buffer += aText;
 			}
-			
-			FormatStart = -1;
+			break;
 		}
-		else 
+		case CFormatTemplate::SEGMENT_STR:
+			Buffer += va_arg(VarArgsIter, const char *);
+			break;
+		case CFormatTemplate::SEGMENT_LSTR: // Translate string
 		{
-			if(pText[Iter] == '{')
-			{
-				Iter ++;
-				FormatStart = Iter;
-			}else
-			{
-				Buffer.append(pText + Iter, str_utf8_forward(pText, Iter) - Iter);
-			}
+			const char* pStr = va_arg(VarArgsIter, const char *);
+			const char* pTranslateStr = pLanguage->Localize(pStr);
+			if(!pTranslateStr || !pTranslateStr[0])
+				Buffer += pStr;
+			else 
+				Buffer += pTranslateStr;
+			break;
+		}
+		case CFormatTemplate::SEGMENT_INT:
+			Buffer += std::to_string(va_arg(VarArgsIter, int));
+			break;
+		case CFormatTemplate::SEGMENT_NUM: // number (double)
+			Buffer += std::to_string(va_arg(VarArgsIter, double));
+			break;
 		}
+	}
+
+	va_end(VarArgsIter);
+}
 
-		Iter = str_utf8_forward(pText, Iter);
+void CLocalization::Format_V(std::string& Buffer, const char *pLanguageCode, const char *pText, va_list VarArgs)
+{
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
+	if(!pLanguage)
+	{
+		Buffer.append(pText);
+		return;
 	}
+
+	FormatTemplate(Buffer, pLanguage, pLanguage->CompileTemplate(pText), VarArgs);
 }
 
 void CLocalization::Format(std::string& Buffer, const char *pLanguageCode, const char *pText, ...)
@@ -403,11 +509,33 @@ void CLocalization::Format(std::string& Buffer, const char *pLanguageCode, const
 	va_end(VarArgs);
 }
 
-void CLocalization::Format_VL(std::string& Buffer, const char *pLanguageCode, const char *pText, va_list VarArgs)
+const CFormatTemplate *CLocalization::FindTemplateWithDepth(CLanguage *pLanguage, CLocalizeKey Key, int Depth)
 {
-	const char *pLocalText = Localize(pLanguageCode, pText);
-	
-	Format_V(Buffer, pLanguageCode, pLocalText, VarArgs);
+	const CFormatTemplate *pTemplate = pLanguage->FindTemplate(Key);
+	if(pTemplate)
+		return pTemplate;
+	else if(pLanguage->GetParentFilename()[0] && str_comp(pLanguage->GetFilename(), pLanguage->GetParentFilename()) && Depth < 4)
+	{
+		CLanguage *pParent = FindLanguage(pLanguage->GetParentFilename());
+		return pParent ? FindTemplateWithDepth(pParent, Key, Depth+1) : nullptr;
+	}
+	return nullptr;
+}
+
+void CLocalization::Format_VL(std::string& Buffer, const char *pLanguageCode, CLocalizeKey Key, va_list VarArgs)
+{
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
+	if(!pLanguage)
+	{
+		Buffer.append(Key.m_pText);
+		return;
+	}
+
+	// the translation comes compiled, the source text is compiled once
+	const CFormatTemplate *pTemplate = FindTemplateWithDepth(pLanguage, Key, 0);
+	if(!pTemplate)
+		pTemplate = pLanguage->CompileTemplate(Key);
+	FormatTemplate(Buffer, pLanguage, pTemplate, VarArgs);
 }
 
 void CLocalization::Format_L(std::string& Buffer, const char *pLanguageCode, const char *pText, ...)
@@ -1,13 +1,81 @@
 #ifndef __LUNARTEE_LOCALIZATION__
 #define __LUNARTEE_LOCALIZATION__
 
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <base/uuid.h>
 
-#define _(TEXT) TEXT
+#include <engine/shared/jobs.h>
+
+// 64-bit FNV-1a of the source text, the key of the translations
+constexpr uint64_t LocalizeHash(const char *pText)
+{
+	uint64_t Hash = 0xcbf29ce484222325ull;
+	for(; *pText; pText++)
+		Hash = (Hash ^ (unsigned char)*pText) * 0x100000001b3ull;
+	return Hash;
+}
+
+// source text with its hash, _() hashes literals at compile time
+struct CLocalizeKey
+{
+	const char *m_pText;
+	uint64_t m_Hash;
+
+	constexpr CLocalizeKey(const char *pText, uint64_t Hash) :
+		m_pText(pText), m_Hash(Hash) {}
+	CLocalizeKey(const char *pText) :
+		m_pText(pText), m_Hash(LocalizeHash(pText)) {}
+
+	constexpr operator const char *() const { return m_pText; }
+};
+
+#define _(TEXT) CLocalizeKey(TEXT, std::integral_constant<uint64_t, LocalizeHash(TEXT)>::value)
+
+// a format text split once into literals and {UUID} {STR} {LSTR} {INT} {NUM}
+// placeholders, formatting only walks the segments
+class CFormatTemplate
+{
+public:
+	enum
+	{
+		SEGMENT_LITERAL = 0,
+		SEGMENT_UUID,
+		SEGMENT_STR,
+		SEGMENT_LSTR,
+		SEGMENT_INT,
+		SEGMENT_NUM,
+	};
+
+	struct CSegment
+	{
+		int m_Type;
+		// the literal in m_Text
+		int m_Start;
+		int m_Length;
+	};
+
+	CFormatTemplate() = default;
+	CFormatTemplate(const char *pText) { Compile(pText); }
+	void Compile(const char *pText);
+
+	const char *Text() const { return m_Text.c_str(); }
+	const std::vector<CSegment> &Segments() const { return m_vSegments; }
+	// literal bytes plus a guess for the placeholders
+	int SizeHint() const { return m_SizeHint; }
+
+private:
+	std::string m_Text;
+	std::vector<CSegment> m_vSegments;
+	int m_SizeHint = 0;
+};
 
 class CLocalization
 {
@@ -23,9 +91,23 @@ public:
 		char m_aFilename[64];
 		char m_aParentFilename[64];
 		char m_aFlag[16];
-		bool m_Loaded;
-		
-		std::map<CUuid, std::string> m_Translations;
+
+	public:
+		struct CTable
+		{
+			// texts of the server by hash, compiled by the load job,
+			// the strings of datapacks by uuid
+			std::unordered_map<uint64_t, CFormatTemplate> m_Translations;
+			std::map<CUuid, std::string> m_UuidTranslations;
+		};
+
+	protected:
+		// built by the load job and swapped in whole, null until the first load
+		std::atomic<CTable *> m_pTable;
+
+		// texts without translation that were formatted in this language,
+		// only used on the game thread
+		std::unordered_map<uint64_t, CFormatTemplate> m_TemplateCache;
 
 	public:
 		CLanguage();
@@ -38,22 +120,60 @@ public:
 		inline const char *GetFilename() const { return m_aFilename; }
 		inline const char *GetName() const { return m_aName; }
 		inline const char *GetFlag() const { return m_aFlag; }
-		inline bool IsLoaded() const { return m_Loaded; }
+		inline bool IsLoaded() const { return m_pTable.load() != nullptr; }
 
-		bool Load(CLocalization* pLocalization, class IStorage* pStorage, std::string FileStr, class CDatapack *pDatapack = nullptr);
-		bool Load(CLocalization* pLocalization, class IStorage* pStorage);
-		const char *Localize(const char *pKey);
+		static void Load(CTable *pTable, const std::string &FileStr, const struct CDatapack *pDatapack = nullptr);
+		// returns the previous table, the caller frees it once nobody reads it
+		CTable *SwapTable(CTable *pTable) { return m_pTable.exchange(pTable); }
+		const char *Localize(CLocalizeKey Key);
 		const char *Localize(const CUuid Uuid);
+		// the compiled translation, nullptr if there is none
+		const CFormatTemplate *FindTemplate(CLocalizeKey Key);
+		// the compiled text itself, cached
+		const CFormatTemplate *CompileTemplate(CLocalizeKey Key);
 	};
 
 protected:
 	CLanguage* m_pMainLanguage;
 
+	// loads the tables of all languages off the game thread, each datapack
+	// is opened once for all of them
+	class CLoadJob : public IJob
+	{
+		class IStorage *m_pStorage;
+		void Run() override;
+
+	public:
+		CLoadJob(class IStorage *pStorage, std::vector<CLanguage *> vpLanguages, std::vector<struct CDatapack> vDatapacks);
+		~CLoadJob();
+
+		std::vector<CLanguage *> m_vpLanguages;
+		std::vector<struct CDatapack> m_vDatapacks;
+		// replaced tables, freed on the game thread after the job
+		std::vector<CLanguage::CTable *> m_vpOldTables;
+	};
+
+	std::shared_ptr<CLoadJob> m_pLoadJob;
+	bool m_ReloadWanted;
+
+	std::unordered_map<std::string, CLanguage*> m_LanguagesByCode;
+	void AddLanguage(CLanguage *pLanguage);
+
 public:
 	std::vector<CLanguage*> m_vpLanguages;
 
+	// the language of the code, the main language if there is none
+	CLanguage *FindLanguage(const char *pLanguageCode);
+
+	// reload all languages with the enabled datapacks on the next update
+	void RequestReload() { m_ReloadWanted = true; }
+	// game thread, starts wanted reloads and frees the tables they replaced
+	void Update(class IServer *pServer);
+
 protected:
-	const char *LocalizeWithDepth(const char *pLanguageCode, const char *pText, int Depth);
+	const char *LocalizeWithDepth(const char *pLanguageCode, CLocalizeKey Key, int Depth);
+	const CFormatTemplate *FindTemplateWithDepth(CLanguage *pLanguage, CLocalizeKey Key, int Depth);
+	void FormatTemplate(std::string& Buffer, CLanguage *pLanguage, const CFormatTemplate *pTemplate, va_list VarArgs);
 	std::string LocalizeWithDepth(const char *pLanguageCode, CUuid Uuid, int Depth);
 public:
 
@@ -66,14 +186,14 @@ public:
 	virtual void LoadDatapack(class CUnzip *pUnzip, std::string Buffer);
 
 	//localize
-	const char *Localize(const char *pLanguageCode, const char *pText);
+	const char *Localize(const char *pLanguageCode, CLocalizeKey Key);
 	std::string Localize(const char *pLanguageCode, CUuid Uuid);
 	
 	//format
 	void Format_V(std::string& Buffer, const char *pLanguageCode, const char *pText, va_list VarArgs);
 	void Format(std::string& Buffer, const char *pLanguageCode, const char *pText, ...);
 	//localize, format
-	void Format_VL(std::string& Buffer, const char *pLanguageCode, const char *pText, va_list VarArgs);
+	void Format_VL(std::string& Buffer, const char *pLanguageCode, CLocalizeKey Key, va_list VarArgs);
 	void Format_L(std::string& Buffer, const char *pLanguageCode, const char *pText, ...);
 };
 
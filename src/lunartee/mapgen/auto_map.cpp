@@ -5,6 +5,7 @@
 #include <engine/shared/linereader.h>
 
 #include <game/mapitems.h>
+#include <game/prng.h>
 
 #include "auto_map.h"
 #include "mapcreater.h"
@@ -134,7 +135,7 @@ const char* CAutoMapper::GetConfigName(int Index)
 	return m_lConfigs[Index].m_aName;
 }
 
-void CAutoMapper::Proceed(SLayerTilemap *pLayer, int ConfigID)
+void CAutoMapper::Proceed(SLayerTilemap *pLayer, int ConfigID, CPrng *pRandom)
 {
 	if(!m_FileLoaded || ConfigID < 0 || ConfigID >= m_lConfigs.size())
 		return;
@@ -213,7 +214,7 @@ void CAutoMapper::Proceed(SLayerTilemap *pLayer, int ConfigID)
 				}
 
 				if(RespectRules &&
-					(pConf->m_aIndexRules[i].m_RandomValue <= 1 || (int)((float)rand() / ((float)RAND_MAX + 1) * pConf->m_aIndexRules[i].m_RandomValue) == 1))
+					(pConf->m_aIndexRules[i].m_RandomValue <= 1 || (int)(pRandom->RandomFloat() * pConf->m_aIndexRules[i].m_RandomValue) == 1))
 				{
 					pTile->m_Index = pConf->m_aIndexRules[i].m_ID;
 					pTile->m_Flags = pConf->m_aIndexRules[i].m_Flag;
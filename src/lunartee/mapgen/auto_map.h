@@ -42,7 +42,7 @@ public:
 	CAutoMapper(class CMapCreater *pCreater);
 
 	void Load(const char* pTileName);
-	void Proceed(struct SLayerTilemap *pLayer, int ConfigID);
+	void Proceed(struct SLayerTilemap *pLayer, int ConfigID, class CPrng *pRandom);
 
 	int ConfigNamesNum() { return m_lConfigs.size(); }
 	const char* GetConfigName(int Index);
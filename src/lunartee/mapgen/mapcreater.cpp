@@ -409,7 +409,7 @@ SText *SLayerText::AddText(const char* pText, int Size, ivec2 Pos, bool Outline,
     return pTextObj;
 }
 
-void CMapCreater::AutoMap(SLayerTilemap *pTilemap, const char* pConfigName)
+void CMapCreater::AutoMap(SLayerTilemap *pTilemap, const char* pConfigName, CPrng *pRandom)
 {
     CAutoMapper AutoMapper(this);
 
@@ -433,7 +433,7 @@ void CMapCreater::AutoMap(SLayerTilemap *pTilemap, const char* pConfigName)
         return;
     }
 
-    AutoMapper.Proceed(pTilemap, ConfigID);
+    AutoMapper.Proceed(pTilemap, ConfigID, pRandom);
 }
 
 static int AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize)
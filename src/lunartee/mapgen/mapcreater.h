@@ -38,7 +38,7 @@ public:
 
     SGroupInfo *AddGroup(const char* pName);
 
-    void AutoMap(SLayerTilemap *pTilemap, const char* pConfigName);
+    void AutoMap(SLayerTilemap *pTilemap, const char* pConfigName, class CPrng *pRandom);
 
 	bool SaveMap(ELunarMapType MapType, const char* pMap);
 };
@@ -64,8 +64,10 @@ void CMapGen::GenerateGameLayer()
 
 	m_pGameTiles = pLayer->AddTiles(Width, Height);
 
-	srand(time(0));
-	const siv::PerlinNoise::seed_type Seed = (unsigned int) clamp(rand(), 0, RAND_MAX);
+	// the doodads and the automapper draw from the same generator
+	uint64_t MapSeed = g_Config.m_SvMapSeed ? (uint64_t) g_Config.m_SvMapSeed : (uint64_t) time(0);
+	m_Random.Seed(Server()->SessionSeed(IServer::SEED_MAP, MapSeed));
+	const siv::PerlinNoise::seed_type Seed = m_Random.RandomBits();
 	const siv::PerlinNoise Perlin{ Seed };
 	
 	// fill tiles to solid
@@ -191,7 +193,7 @@ void CMapGen::GenerateDoodadsLayer()
 	{
 		for(int x = 0;x < Width-9;x ++)
 		{
-			if(random_int(0, 100) < 80)
+			if(m_Random.RandomInt(0, 100) < 80)
 				continue;
 
 			if(m_pDoodadsTiles[(y+1)*Width+x].m_Index != 0
@@ -285,7 +287,7 @@ void CMapGen::GenerateHookable(CMapGen *pParent)
 
 	pParent->m_HookableReady = true;
 
-	pParent->m_pMapCreater->AutoMap(pParent->m_pHookableLayer, "Default");
+	pParent->m_pMapCreater->AutoMap(pParent->m_pHookableLayer, "Default", &pParent->m_Random);
 }
 
 void CMapGen::GenerateUnhookable(CMapGen *pParent)
@@ -308,7 +310,7 @@ void CMapGen::GenerateUnhookable(CMapGen *pParent)
 
 	pParent->m_UnhookableReady = true;
 
-	pParent->m_pMapCreater->AutoMap(pParent->m_pUnhookableLayer, "Random Silver");
+	pParent->m_pMapCreater->AutoMap(pParent->m_pUnhookableLayer, "Random Silver", &pParent->m_Random);
 }
 
 void CMapGen::GenerateCenter()
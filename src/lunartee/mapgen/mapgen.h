@@ -12,6 +12,7 @@
 
 #include <game/mapitems.h>
 #include <game/gamecore.h>
+#include <game/prng.h>
 
 class CServer;
 
@@ -40,6 +41,9 @@ public:
 	bool m_HookableReady;
 	bool m_UnhookableReady;
 
+	// every random choice of the map, seeded by sv_map_seed or the recording
+	CPrng m_Random;
+
 	IStorage* Storage() { return m_pStorage; };
 	IConsole* Console() { return m_pConsole; };
 	CServer* Server() { return m_pServer; };
@@ -90,7 +90,6 @@ void CSql::CreateTables()
 		s_SqlMutex.lock();
 		try 
 		{
-			m_pResult = nullptr;
 			// Create connection
 			CSqlConnection *pConnection = new CSqlConnection();
 			
@@ -111,9 +110,18 @@ void CSql::CreateTables()
                         OwnerID INTEGER NOT NULL, \
                         Num INTEGER NOT NULL, \
 						Uuid TEXT NOT NULL \
+                    ); \
+                    CREATE TABLE IF NOT EXISTS lt_trade( \
+                        ID SERIAL NOT NULL, \
+                        Uuid TEXT NOT NULL, \
+                        TraderUuid TEXT NOT NULL, \
+                        TraderIndex INTEGER NOT NULL, \
+                        GiveUuid TEXT NOT NULL, \
+                        GiveNum INTEGER NOT NULL, \
+                        Needs TEXT NOT NULL \
                     );"
 				);
-				m_pResult = pWork->Commit(ExecBuffer.c_str());
+				delete pWork->Commit(ExecBuffer.c_str());
 			}
 			pConnection->Disconnect();
 		} 
@@ -126,15 +134,14 @@ void CSql::CreateTables()
 	Thread.join();
 }
 
-SqlResult *CSql::Execute(const char* pExec)
+std::unique_ptr<SqlResult> CSql::Execute(const char* pExec)
 {
-	std::thread Thread([this, pExec]()
+	// every call has its own result, calls from several threads don't share it
+	std::unique_ptr<SqlResult> pResult;
+	std::thread Thread([&pResult, pExec]()
 	{
 		try 
 		{
-			if(m_pResult)
-				delete m_pResult;
-			m_pResult = nullptr;
 			// Create connection
 			CSqlConnection *pConnection = new CSqlConnection();
 			
@@ -143,7 +150,7 @@ SqlResult *CSql::Execute(const char* pExec)
 			if(pConnection->IsOpen()) 
 			{
 				CSqlWork *pWork = new CSqlWork(pConnection->Connection());
-				m_pResult = pWork->Commit(pExec);
+				pResult.reset(pWork->Commit(pExec));
 			}
 			pConnection->Disconnect();
 		} 
@@ -154,7 +161,62 @@ SqlResult *CSql::Execute(const char* pExec)
 	});
 	Thread.join();
 
-	return m_pResult;
+	return pResult;
+}
+
+std::shared_ptr<IJob> CSql::CJobQueue::Add(std::shared_ptr<IJob> pJob)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	m_vpJobs.push_back(std::move(pJob));
+	if(m_Running)
+		return nullptr;
+	m_Running = true;
+	return std::make_shared<CRunJob>(shared_from_this());
+}
+
+std::shared_ptr<IJob> CSql::CJobQueue::Pop()
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	if(m_vpJobs.empty())
+	{
+		m_Running = false;
+		return nullptr;
+	}
+	std::shared_ptr<IJob> pJob = std::move(m_vpJobs.front());
+	m_vpJobs.pop_front();
+	return pJob;
+}
+
+void CSql::CJobQueue::CRunJob::Run()
+{
+	while(true)
+	{
+		std::lock_guard<std::mutex> RunLock(m_pQueue->m_RunLock);
+		std::shared_ptr<IJob> pJob = m_pQueue->Pop();
+		if(!pJob)
+			return;
+		CJobPool::RunBlocking(pJob.get());
+	}
+}
+
+void CSql::AddJob(std::shared_ptr<IJob> pJob)
+{
+	std::shared_ptr<IJob> pRunJob = m_pJobQueue->Add(std::move(pJob));
+	if(pRunJob)
+		GameServer()->Server()->CreateNewTheardJob(pRunJob);
+}
+
+void CSql::FlushJobs()
+{
+	// the pool drops the jobs it hasn't started when it is destroyed
+	while(true)
+	{
+		std::lock_guard<std::mutex> RunLock(m_pJobQueue->m_RunLock);
+		std::shared_ptr<IJob> pJob = m_pJobQueue->Pop();
+		if(!pJob)
+			return;
+		CJobPool::RunBlocking(pJob.get());
+	}
 }
 
 CSql g_Postgresql;
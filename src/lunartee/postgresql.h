@@ -3,7 +3,13 @@
 
 #define ACCOUNTS_PIN_LENTH 6
 
+#include <engine/shared/jobs.h>
+
 #include <pqxx/pqxx>
+
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 
 using SqlConnection = pqxx::connection;
@@ -60,7 +66,35 @@ class CSql
 	std::string m_IP;
 	unsigned short m_Port;
 
-	SqlResult *m_pResult;
+	// runs the database jobs one after another in the order they were added,
+	// so e.g. a read sees every write that was added before it
+	class CJobQueue : public std::enable_shared_from_this<CJobQueue>
+	{
+		class CRunJob : public IJob
+		{
+			std::shared_ptr<CJobQueue> m_pQueue;
+			void Run() override;
+
+		public:
+			CRunJob(std::shared_ptr<CJobQueue> pQueue) :
+				m_pQueue(std::move(pQueue)) {}
+		};
+
+		std::mutex m_Lock;
+		std::deque<std::shared_ptr<IJob>> m_vpJobs;
+		bool m_Running = false;
+
+	public:
+		// held from taking a job until it is done, so they never overlap
+		std::mutex m_RunLock;
+
+		// the job to start on the pool, if none is running yet
+		std::shared_ptr<IJob> Add(std::shared_ptr<IJob> pJob);
+		// the next job, nullptr if there is none
+		std::shared_ptr<IJob> Pop();
+	};
+	std::shared_ptr<CJobQueue> m_pJobQueue = std::make_shared<CJobQueue>();
+
 public:
 	const char* Database() { return m_Database.c_str(); }
 	const char* Username() { return m_Username.c_str(); }
@@ -72,19 +106,19 @@ public:
 
     void Init(class CGameContext *pGameServer);
 
-	~CSql() 
-	{
-		if(m_pResult)
-			delete m_pResult;
-		m_pResult = nullptr;
-	}
+	~CSql() = default;
 
-	SqlResult *Execute(const char* pExec);
+	// runs the statement right away, nullptr if it failed
+	std::unique_ptr<SqlResult> Execute(const char* pExec);
+	// runs the job after the ones added before
+	void AddJob(std::shared_ptr<IJob> pJob);
+	// runs the jobs that are left on this thread, for the shutdown
+	void FlushJobs();
 
 	void CreateTables();
 
 	template<SqlType T>
-	std::enable_if_t<T == SqlType::INSERT, SqlResult*> Execute(const char* pTable, const char* pExec)
+	std::enable_if_t<T == SqlType::INSERT, std::unique_ptr<SqlResult>> Execute(const char* pTable, const char* pExec)
 	{
 		std::string Buffer;
 		Buffer.append("INSERT INTO ");
@@ -96,7 +130,7 @@ public:
 	}
 
 	template<SqlType T>
-	std::enable_if_t<T == SqlType::UPDATE, SqlResult*> Execute(const char* pTable, const char* pExec)
+	std::enable_if_t<T == SqlType::UPDATE, std::unique_ptr<SqlResult>> Execute(const char* pTable, const char* pExec)
 	{
 		std::string Buffer; 
 		Buffer.append("UPDATE ");
@@ -108,7 +142,7 @@ public:
 	}
 
 	template<SqlType T>
-	std::enable_if_t<T == SqlType::DELETE, SqlResult*> Execute(const char* pTable, const char* pExec)
+	std::enable_if_t<T == SqlType::DELETE, std::unique_ptr<SqlResult>> Execute(const char* pTable, const char* pExec)
 	{
 		std::string Buffer;
 		Buffer.append("DELETE FROM ");
@@ -120,7 +154,7 @@ public:
 	}
 
 	template<SqlType T>
-	std::enable_if_t<T == SqlType::SELECT, SqlResult*> Execute(const char* pTable, const char* pExec, const char* pSelect = "*")
+	std::enable_if_t<T == SqlType::SELECT, std::unique_ptr<SqlResult>> Execute(const char* pTable, const char* pExec, const char* pSelect = "*")
 	{
 		std::string Buffer;
 		Buffer.append("SELECT ");
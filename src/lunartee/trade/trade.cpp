@@ -4,7 +4,9 @@
 #include <game/server/gamecontext.h>
 
 #include <lunartee/datacontroller.h>
+#include <lunartee/postgresql.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "trade.h"
@@ -57,22 +59,7 @@ void CTradeCore::MenuShopper(int ClientID, const char* pCmd, const char* pReason
             return;
         
         int TraderID = -1;
-        CTradeCore::STradeData *pTradeData = nullptr;
-        for(auto& Trader : pThis->m_vTraders)
-        {
-            for(auto &Trade : Trader.second)
-		    {
-                if(Uuid == Trade.m_Uuid)
-                {
-                    pTradeData = &Trade;
-                    TraderID = Trader.first;
-                    break;
-                }
-            }
-            if(pTradeData)
-                break;
-        }
-        
+        CTradeCore::STradeData *pTradeData = pThis->FindOffer(Uuid, &TraderID);
         if(!pTradeData)
             return;
         
@@ -82,21 +69,25 @@ void CTradeCore::MenuShopper(int ClientID, const char* pCmd, const char* pReason
             return;
         }
 
-        for(auto& Need : pTradeData->m_Needs)
+        if(Datas()->Item()->IsInvSyncing(ClientID) || (TraderID >= 0 && Datas()->Item()->IsInvSyncing(TraderID)))
         {
-            if(Datas()->Item()->GetInvItemNum(Need.first, ClientID) < Need.second)
-            {
-                pThis->GameServer()->SendChatTarget_Localization(ClientID, _("You don't have enough resources"));
-                return;
-            }
+            pThis->GameServer()->SendChatTarget_Localization(ClientID, _("Your items are loading, please wait"));
+            return;
         }
 
+        // pay and get the item together
+        CInvTransaction Transaction(Datas()->Item(), ClientID);
         for(auto& Need : pTradeData->m_Needs)
         {
-            Datas()->Item()->AddInvItemNum(Need.first, -Need.second, ClientID);
+            Transaction.Add(Need.first, -Need.second);
         }
+        Transaction.Add(pTradeData->m_Give.first, pTradeData->m_Give.second, true);
 
-        Datas()->Item()->AddInvItemNum(pTradeData->m_Give.first, pTradeData->m_Give.second, ClientID, true, true);
+        if(!Transaction.Commit())
+        {
+            pThis->GameServer()->SendChatTarget_Localization(ClientID, _("You don't have enough resources"));
+            return;
+        }
 
         if(TraderID > 0)
         {
@@ -105,12 +96,14 @@ void CTradeCore::MenuShopper(int ClientID, const char* pCmd, const char* pReason
                 pTradeData->m_Give.first,
                 pTradeData->m_Give.second);
 
-            pThis->m_vTraders[TraderID].erase(std::find(pThis->m_vTraders[TraderID].begin(), pThis->m_vTraders[TraderID].end(), *pTradeData));
-            for(auto& Need : pTradeData->m_Needs)
+            // the offer of a player is filled once
+            CTradeCore::STradeData Trade = *pTradeData;
+            pThis->RemoveOffer(Trade.m_Uuid);
+            for(auto& Need : Trade.m_Needs)
             {
                 Datas()->Item()->AddInvItemNum(Need.first, Need.second, TraderID);
             }
-            Datas()->Item()->AddInvItemNum(pTradeData->m_Give.first, -pTradeData->m_Give.second, ClientID, true, false);
+            Datas()->Item()->AddInvItemNum(Trade.m_Give.first, -Trade.m_Give.second, TraderID, true, false);
         }
 
         return;
@@ -199,9 +192,30 @@ void CTradeCore::MenuTrade(int ClientID, const char* pCmd, const char* pReason,
         return;
     }
 
+    // only the shops that sell the item
+    std::vector<int> vSellers;
+    bool Search = false;
+    CUuid SearchUuid;
+    if(str_startswith(pCmd, "SELLS") && !ParseUuid(&SearchUuid, pCmd + 6))
+    {
+        Search = true;
+        if(const std::vector<CUuid> *pOffers = pThis->FindSellers(SearchUuid))
+        {
+            for(auto &Offer : *pOffers)
+                vSellers.push_back(pThis->m_TradersByOffer[Offer]);
+        }
+    }
+
 	std::vector<CMenuOption> Options;
 
 	Options.push_back(CMenuOption(_("Trade"), 0, "# {STR}"));
+    if(Search)
+    {
+        Options.push_back(CMenuOption(
+            pThis->GameServer()->LocalizeFormat(
+                pThis->GameServer()->Server()->GetClientLanguage(ClientID),
+                _("Shops that sell {UUID}"), SearchUuid), 0, "## {STR}"));
+    }
 	Options.push_back(CMenuOption(" ", 0, "{STR}"));
 
     for(auto& Trader : pThis->m_vTraders)
@@ -211,6 +225,11 @@ void CTradeCore::MenuTrade(int ClientID, const char* pCmd, const char* pReason,
             continue;
         }
 
+        if(Search && std::find(vSellers.begin(), vSellers.end(), Trader.first) == vSellers.end())
+        {
+            continue;
+        }
+
         int TraderID = Trader.first;
         CPlayer *pTrader = pThis->GameServer()->GetPlayer(TraderID);
 
@@ -238,17 +257,212 @@ void CTradeCore::RegisterMenu()
     Menu()->Register("SHOPPER", "TRADE", this, MenuShopper);
 }
 
-void CTradeCore::AddTrade(int TraderID, STradeData Data)
+void CTradeCore::AddTrade(int TraderID, STradeData Data, bool Stored)
 {
+    m_TradersByOffer[Data.m_Uuid] = TraderID;
+    m_OffersByItem[Data.m_Give.first].push_back(Data.m_Uuid);
+    if(!Stored)
+        m_vAdded.push_back(Data);
+
     if(!m_vTraders.count(TraderID))
         m_vTraders.insert(std::make_pair(TraderID, std::vector<STradeData>()));
     m_vTraders[TraderID].push_back(Data);
 }
 
+void CTradeCore::DropOffer(const STradeData &Data)
+{
+    m_TradersByOffer.erase(Data.m_Uuid);
+
+    auto Iter = m_OffersByItem.find(Data.m_Give.first);
+    if(Iter != m_OffersByItem.end())
+    {
+        Iter->second.erase(std::remove(Iter->second.begin(), Iter->second.end(), Data.m_Uuid), Iter->second.end());
+        if(Iter->second.empty())
+            m_OffersByItem.erase(Iter);
+    }
+
+    // never written, so there is nothing to remove
+    auto Added = std::find(m_vAdded.begin(), m_vAdded.end(), Data);
+    if(Added != m_vAdded.end())
+        m_vAdded.erase(Added);
+    else
+        m_vRemoved.push_back(Data.m_Uuid);
+}
+
 void CTradeCore::RemoveTrade(int TraderID)
 {
     if(!m_vTraders.count(TraderID))
         return;
 
+    for(auto &Trade : m_vTraders[TraderID])
+        DropOffer(Trade);
     m_vTraders.erase(TraderID);
+}
+
+void CTradeCore::RemoveOffer(CUuid Uuid)
+{
+    int TraderID;
+    STradeData *pData = FindOffer(Uuid, &TraderID);
+    if(!pData)
+        return;
+
+    DropOffer(*pData);
+    std::vector<STradeData> &vTrades = m_vTraders[TraderID];
+    vTrades.erase(std::find(vTrades.begin(), vTrades.end(), *pData));
+}
+
+CTradeCore::STradeData *CTradeCore::FindOffer(CUuid Uuid, int *pTraderID)
+{
+    auto Iter = m_TradersByOffer.find(Uuid);
+    if(Iter == m_TradersByOffer.end())
+        return nullptr;
+
+    for(auto &Trade : m_vTraders[Iter->second])
+    {
+        if(Trade.m_Uuid == Uuid)
+        {
+            *pTraderID = Iter->second;
+            return &Trade;
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<CUuid> *CTradeCore::FindSellers(CUuid ItemUuid) const
+{
+    auto Iter = m_OffersByItem.find(ItemUuid);
+    return Iter == m_OffersByItem.end() ? nullptr : &Iter->second;
+}
+
+bool CTradeCore::TakeStoredTrade(CUuid TraderUuid, int TraderIndex, CUuid GiveUuid, STradeData *pData)
+{
+    auto Iter = m_StoredTrades.find(std::make_pair(TraderUuid, TraderIndex));
+    if(Iter == m_StoredTrades.end())
+        return false;
+
+    bool Found = false;
+    while(!Iter->second.empty() && !Found)
+    {
+        // the datapack may have changed the trade since
+        Found = Iter->second.back().m_Give.first == GiveUuid;
+        if(Found)
+            *pData = Iter->second.back();
+        else
+            m_vRemoved.push_back(Iter->second.back().m_Uuid);
+        Iter->second.pop_back();
+    }
+    if(Iter->second.empty())
+        m_StoredTrades.erase(Iter);
+    return Found;
+}
+
+void CTradeCore::LoadTrades()
+{
+    std::unique_ptr<SqlResult> pSqlResult = Sql()->Execute<SqlType::SELECT>("lt_trade", ";", "*");
+    if(!pSqlResult)
+    {
+        log_error("trade", "failed to load the trades");
+        return;
+    }
+
+    int Num = 0;
+    for(SqlResult::const_iterator Iter = pSqlResult->begin(); Iter != pSqlResult->end(); ++ Iter)
+    {
+        STradeData Data;
+        if(ParseUuid(&Data.m_Uuid, Iter["Uuid"].as<std::string>().c_str()) ||
+            ParseUuid(&Data.m_TraderUuid, Iter["TraderUuid"].as<std::string>().c_str()) ||
+            ParseUuid(&Data.m_Give.first, Iter["GiveUuid"].as<std::string>().c_str()))
+            continue;
+        Data.m_TraderIndex = Iter["TraderIndex"].as<int>();
+        Data.m_Give.second = Iter["GiveNum"].as<int>();
+
+        nlohmann::json Needs = nlohmann::json::parse(Iter["Needs"].as<std::string>(), nullptr, false);
+        if(!Needs.is_object())
+            continue;
+        for(auto &Need : Needs.items())
+        {
+            CUuid NeedUuid;
+            if(ParseUuid(&NeedUuid, Need.key().c_str()) || !Need.value().is_number_integer())
+                continue;
+            Data.m_Needs[NeedUuid] = Need.value().get<int>();
+        }
+
+        m_StoredTrades[std::make_pair(Data.m_TraderUuid, Data.m_TraderIndex)].push_back(Data);
+        Num ++;
+    }
+    log_info("trade", "loaded %d trades", Num);
+}
+
+void CTradeCore::CSaveJob::Run()
+{
+    // one statement, so the book in the database is never half written
+    std::string Buffer;
+    char aUuidStr[UUID_MAXSTRSIZE];
+    if(!m_vRemoved.empty())
+    {
+        Buffer.append("DELETE FROM lt_trade WHERE Uuid IN (");
+        for(unsigned i = 0; i < m_vRemoved.size(); i ++)
+        {
+            FormatUuid(m_vRemoved[i], aUuidStr, sizeof(aUuidStr));
+            if(i)
+                Buffer.append(", ");
+            Buffer.append("'");
+            Buffer.append(aUuidStr);
+            Buffer.append("'");
+        }
+        Buffer.append(");");
+    }
+
+    if(!m_vAdded.empty())
+    {
+        Buffer.append("INSERT INTO lt_trade (Uuid, TraderUuid, TraderIndex, GiveUuid, GiveNum, Needs) VALUES ");
+        for(unsigned i = 0; i < m_vAdded.size(); i ++)
+        {
+            const STradeData &Data = m_vAdded[i];
+            nlohmann::json Needs = nlohmann::json::object();
+            for(auto &Need : Data.m_Needs)
+            {
+                FormatUuid(Need.first, aUuidStr, sizeof(aUuidStr));
+                Needs[aUuidStr] = Need.second;
+            }
+
+            if(i)
+                Buffer.append(", ");
+            FormatUuid(Data.m_Uuid, aUuidStr, sizeof(aUuidStr));
+            Buffer.append("('");
+            Buffer.append(aUuidStr);
+            FormatUuid(Data.m_TraderUuid, aUuidStr, sizeof(aUuidStr));
+            Buffer.append("', '");
+            Buffer.append(aUuidStr);
+            Buffer.append("', ");
+            Buffer.append(std::to_string(Data.m_TraderIndex));
+            FormatUuid(Data.m_Give.first, aUuidStr, sizeof(aUuidStr));
+            Buffer.append(", '");
+            Buffer.append(aUuidStr);
+            Buffer.append("', ");
+            Buffer.append(std::to_string(Data.m_Give.second));
+            Buffer.append(", '");
+            Buffer.append(Needs.dump());
+            Buffer.append("')");
+        }
+        Buffer.append(";");
+    }
+
+    if(!Sql()->Execute(Buffer.c_str()))
+        log_error("trade", "failed to save %d new and %d removed trades", (int) m_vAdded.size(), (int) m_vRemoved.size());
+}
+
+void CTradeCore::Tick()
+{
+    SaveTrades();
+}
+
+void CTradeCore::SaveTrades()
+{
+    if(m_vAdded.empty() && m_vRemoved.empty())
+        return;
+
+    Sql()->AddJob(std::make_shared<CSaveJob>(std::move(m_vAdded), std::move(m_vRemoved)));
+    m_vAdded.clear();
+    m_vRemoved.clear();
 }
\ No newline at end of file
@@ -3,8 +3,14 @@
 
 #include <base/uuid.h>
 
+#include <engine/shared/jobs.h>
+
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 class CTradeCore
 {
@@ -26,16 +32,62 @@ public:
         std::map<CUuid, int> m_Needs;
         std::pair<CUuid, int> m_Give;
 
+        // the bot data and the index of its trade the offer was made for
+        CUuid m_TraderUuid = CUuid();
+        int m_TraderIndex = 0;
+
         bool operator==(const STradeData &Other) const
         {
-            return mem_comp(this, &Other, sizeof(this)) == 0;
+            return m_Uuid == Other.m_Uuid;
         }
     };
 
-    void AddTrade(int TraderID, STradeData Data);
+private:
+    // writes the added and removed offers of a tick in one statement, in
+    // order with the other database jobs
+    class CSaveJob : public IJob
+    {
+        void Run() override;
+
+    public:
+        CSaveJob(std::vector<STradeData> vAdded, std::vector<CUuid> vRemoved) :
+            m_vAdded(std::move(vAdded)), m_vRemoved(std::move(vRemoved)) {}
+
+        const std::vector<STradeData> m_vAdded;
+        const std::vector<CUuid> m_vRemoved;
+    };
+    std::vector<STradeData> m_vAdded;
+    std::vector<CUuid> m_vRemoved;
+
+    // offers of the database no trader has taken again, by trader uuid and index
+    std::map<std::pair<CUuid, int>, std::vector<STradeData>> m_StoredTrades;
+
+    // the trader of each offer, and the offers that give each item
+    std::unordered_map<CUuid, int> m_TradersByOffer;
+    std::unordered_map<CUuid, std::vector<CUuid>> m_OffersByItem;
+    // unindexes the offer and removes it from the database
+    void DropOffer(const STradeData &Data);
+
+public:
+    // reads the offers of the last run, before any trader is made
+    void LoadTrades();
+    void Tick();
+    // queues the changes that aren't written yet
+    void SaveTrades();
+
+    // the offer the trader made last time, removed from the stored ones
+    // stored offers that give another item are dropped
+    bool TakeStoredTrade(CUuid TraderUuid, int TraderIndex, CUuid GiveUuid, STradeData *pData);
+    // Stored for offers that came from TakeStoredTrade
+    void AddTrade(int TraderID, STradeData Data, bool Stored = false);
     void RemoveTrade(int TraderID);
+    // a filled offer
+    void RemoveOffer(CUuid Uuid);
+
+    STradeData *FindOffer(CUuid Uuid, int *pTraderID);
+    // the offers that give the item
+    const std::vector<CUuid> *FindSellers(CUuid ItemUuid) const;
 
-    // TODO: Add database save
     // int = traderID (The user id of the trader, < 0 is bot)
     std::unordered_map<int, std::vector<STradeData>> m_vTraders;
     
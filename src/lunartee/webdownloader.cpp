@@ -1,117 +1,229 @@
-#include <thread>
+#include <algorithm>
 
+#include <base/hash.h>
 #include <base/logger.h>
 #include <base/system.h>
 
+#include <engine/external/json/json.hpp>
 #include <engine/shared/http.h>
 #include <engine/shared/jobs.h>
 #include <engine/server.h>
 #include <engine/storage.h>
 
-#define WIN32_LEAN_AND_MEAN
-#include <curl/curl.h>
-
 #include "webdownloader.h"
 
+#define CACHE_DIR "datapacks/cache"
+#define CACHE_INDEX CACHE_DIR "/index.json"
+
 class CDownloadRequst : public CHttpRequest
 {
     CWebDownloader *m_pWebDownloader;
 
     WEB_CALLBACK m_pfnCallback;
-	char m_aDownloadFile[256];
-	char m_aDownloadDir[256];
-	char m_aDownloadTo[IO_MAX_PATH_LENGTH];
 
 protected:
 	int OnCompletion(int State) override;
 public:
     CWebDownloader *Downloader() { return m_pWebDownloader; }
 
-    void Download(const char* pDownloadFile);
-
-    CDownloadRequst(CWebDownloader *pDownloader, const char *pLink, const char* pDownloadDir, WEB_CALLBACK pfnCallback = nullptr);
+    CDownloadRequst(CWebDownloader *pDownloader, const char *pLink, WEB_CALLBACK pfnCallback = nullptr);
 };
 
-CDownloadRequst::CDownloadRequst(CWebDownloader *pDownloader, const char *pLink, const char* pDownloadDir, WEB_CALLBACK pfnCallback) :
+CDownloadRequst::CDownloadRequst(CWebDownloader *pDownloader, const char *pLink, WEB_CALLBACK pfnCallback) :
 	CHttpRequest(pLink),
 	m_pWebDownloader(pDownloader),
     m_pfnCallback(pfnCallback)
 {
-    str_copy(m_aDownloadDir, pDownloadDir);
 }
 
-void CDownloadRequst::Download(const char* pDownloadFile)
+int CDownloadRequst::OnCompletion(int State)
 {
-    std::string DownloadTo(m_aDownloadDir);
-    DownloadTo += pDownloadFile;
+    State = CHttpRequest::OnCompletion(State);
 
-	WriteToFile(Downloader()->Storage(), DownloadTo.c_str(), IStorage::TYPE_SAVE);
+    char aPath[IO_MAX_PATH_LENGTH];
+    char aFile[128];
+    if(Downloader()->Store(this, State, aPath, sizeof(aPath), aFile, sizeof(aFile)) && m_pfnCallback)
+    {
+        m_pfnCallback(Url(), aPath, aFile);
+    }
 
-    str_copy(m_aDownloadTo, DownloadTo.c_str());
-    str_copy(m_aDownloadFile, pDownloadFile);
+	return State;
 }
 
-int CDownloadRequst::OnCompletion(int State)
+CWebDownloader::CWebDownloader(class IStorage *pStorage, class IServer *pServer)
+{
+    m_pStorage = pStorage;
+    m_pServer = pServer;
+
+    LoadCache();
+}
+
+void CWebDownloader::LoadCache()
 {
-    log_info("webdownload", "download %s to %s done", m_aDownloadFile, m_aDownloadTo);
-    
-    if(m_pfnCallback)
+    void *pData;
+    unsigned Size;
+    if(!Storage()->ReadFile(CACHE_INDEX, IStorage::TYPE_SAVE, &pData, &Size))
+        return;
+
+    nlohmann::json Index = nlohmann::json::parse((const char *) pData, (const char *) pData + Size, nullptr, false);
+    free(pData);
+    if(!Index.is_object())
     {
-        m_pfnCallback(Url(), DestAbsolut(), m_aDownloadFile); // DestAbsolut() = file full path
+        log_warn("webdownload", "ignoring broken cache index");
+        return;
     }
 
-	return CHttpRequest::OnCompletion(State);
+    for(auto &Item : Index.items())
+    {
+        SCacheEntry Entry;
+        Entry.m_Sha256 = Item.value().value("sha256", "");
+        Entry.m_ETag = Item.value().value("etag", "");
+        Entry.m_LastModified = Item.value().value("last-modified", "");
+        Entry.m_FileName = Item.value().value("filename", "");
+        if(!Entry.m_Sha256.empty())
+            m_Cache[Item.key()] = Entry;
+    }
 }
 
-CWebDownloader::CWebDownloader(class IStorage *pStorage, class IServer *pServer)
+void CWebDownloader::SaveCache()
 {
-    m_pStorage = pStorage;
-    m_pServer = pServer;
+    nlohmann::json Index = nlohmann::json::object();
+    for(auto &Item : m_Cache)
+    {
+        Index[Item.first] = {
+            {"sha256", Item.second.m_Sha256},
+            {"etag", Item.second.m_ETag},
+            {"last-modified", Item.second.m_LastModified},
+            {"filename", Item.second.m_FileName},
+        };
+    }
+
+    std::string Data = Index.dump(4);
+    IOHANDLE File = Storage()->OpenFile(CACHE_INDEX ".tmp", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+    if(!File)
+    {
+        log_error("webdownload", "failed to write the cache index");
+        return;
+    }
+    io_write(File, Data.c_str(), Data.size());
+    io_close(File);
+    Storage()->RenameFile(CACHE_INDEX ".tmp", CACHE_INDEX, IStorage::TYPE_SAVE);
+}
 
-    m_LastRequst = nullptr;
+bool CWebDownloader::CachedPath(const SCacheEntry &Entry, char *pPath, int PathSize)
+{
+    char aPath[IO_MAX_PATH_LENGTH];
+    str_format(aPath, sizeof(aPath), CACHE_DIR "/%s.zip", Entry.m_Sha256.c_str());
+    Storage()->GetCompletePath(IStorage::TYPE_SAVE, aPath, pPath, PathSize);
+    return fs_is_file(pPath);
 }
 
-size_t CWebDownloader::PreDownload(void *pData, size_t Size, size_t Number, void *pUser)
+bool CWebDownloader::Store(CHttpRequest *pRequest, int State, char *pPath, int PathSize, char *pFile, int FileSize)
 {
-    CWebDownloader *pDownloader = (CWebDownloader *) pUser;
-    std::string HeaderData((char*) pData);
-    HeaderData.pop_back();
-    HeaderData.pop_back(); // remove ASCII 10, 13
+    std::lock_guard<std::mutex> Lock(m_CacheLock);
 
-    size_t Pos = HeaderData.find("filename=");
-    if(Pos != std::string::npos)
+    if(State == HTTP_DONE && pRequest->StatusCode() == 200)
     {
-        std::string File(HeaderData.substr(Pos + str_length("filename=")));
-        pDownloader->m_LastRequst->Download(File.c_str());
+        SCacheEntry Entry;
+        char aSha256[SHA256_MAXSTRSIZE];
+        sha256_str(pRequest->ResultSha256(), aSha256, sizeof(aSha256));
+        Entry.m_Sha256 = aSha256;
+
+        char aBuf[256];
+        if(pRequest->ResponseHeader("ETag", aBuf, sizeof(aBuf)))
+            Entry.m_ETag = aBuf;
+        if(pRequest->ResponseHeader("Last-Modified", aBuf, sizeof(aBuf)))
+            Entry.m_LastModified = aBuf;
+
+        // github names the zip only in the content disposition
+        const char *pFileName = nullptr;
+        if(pRequest->ResponseHeader("Content-Disposition", aBuf, sizeof(aBuf)))
+            pFileName = str_find_nocase(aBuf, "filename=");
+        if(pFileName)
+        {
+            std::string FileName(pFileName + str_length("filename="));
+            FileName.erase(std::remove(FileName.begin(), FileName.end(), '"'), FileName.end());
+            Entry.m_FileName = FileName;
+        }
+        else
+        {
+            std::string Url(pRequest->Url());
+            Entry.m_FileName = Url.substr(Url.find_last_of('/') + 1);
+        }
+
+        char aCachePath[IO_MAX_PATH_LENGTH];
+        str_format(aCachePath, sizeof(aCachePath), CACHE_DIR "/%s.zip", aSha256);
+        if(!Storage()->RenameFile(pRequest->Dest(), aCachePath, IStorage::TYPE_SAVE))
+        {
+            log_error("webdownload", "failed to move %s into the cache", pRequest->Dest());
+            return false;
+        }
+
+        auto It = m_Cache.find(pRequest->Url());
+        bool Changed = It == m_Cache.end() || It->second.m_Sha256 != Entry.m_Sha256;
+        std::string OldSha256 = It == m_Cache.end() ? "" : It->second.m_Sha256;
+        m_Cache[pRequest->Url()] = Entry;
+        SaveCache();
+
+        // the superseded zip goes, unless another url still has the same content
+        if(Changed && !OldSha256.empty() &&
+            std::none_of(m_Cache.begin(), m_Cache.end(), [&](const auto &Item) { return Item.second.m_Sha256 == OldSha256; }))
+        {
+            str_format(aCachePath, sizeof(aCachePath), CACHE_DIR "/%s.zip", OldSha256.c_str());
+            Storage()->RemoveFile(aCachePath, IStorage::TYPE_SAVE);
+        }
+
+        log_info("webdownload", "downloaded %s as %s%s", pRequest->Url(), aSha256, Changed ? "" : " (unchanged)");
+    }
+    else
+    {
+        // a 304 leaves an empty file, failed requests remove theirs
+        Storage()->RemoveFile(pRequest->Dest(), IStorage::TYPE_SAVE);
+
+        if(!m_Cache.count(pRequest->Url()))
+        {
+            log_error("webdownload", "download of %s failed and it isn't cached", pRequest->Url());
+            return false;
+        }
+
+        if(State == HTTP_DONE && pRequest->StatusCode() == 304)
+            log_info("webdownload", "%s not modified, using the cached file", pRequest->Url());
+        else
+            log_warn("webdownload", "download of %s failed, using the cached file", pRequest->Url());
     }
 
-    return Number * Size;
+    const SCacheEntry &Entry = m_Cache[pRequest->Url()];
+    if(!CachedPath(Entry, pPath, PathSize))
+    {
+        log_error("webdownload", "cached file of %s is missing", pRequest->Url());
+        return false;
+    }
+    str_copy(pFile, Entry.m_FileName.c_str(), FileSize);
+    return true;
 }
 
-void CWebDownloader::Download(const char* pLink, const char* pPath, WEB_CALLBACK pfnCallback)
+void CWebDownloader::Download(const char* pLink, WEB_CALLBACK pfnCallback)
 {
-    std::thread([this, pLink, pPath, pfnCallback](){
-        std::string Path(pPath);
-        if(Path.back() != '/')
-            Path += "/";
-
-        m_LastRequst = std::make_shared<CDownloadRequst>(this, pLink, Path.c_str(), pfnCallback);
-        
-        std::string Link(pLink);
-        m_LastRequst->Download(Link.substr(Link.find_last_of('/') + 1).c_str());
-
-        CURL *pCurl = curl_easy_init();
-        if(pCurl) 
+    std::shared_ptr<CDownloadRequst> pRequest = std::make_shared<CDownloadRequst>(this, pLink, pfnCallback);
+
+    // the final name is only known from the content
+    char aTmpPath[IO_MAX_PATH_LENGTH];
+    str_format(aTmpPath, sizeof(aTmpPath), CACHE_DIR "/%08x.tmp", str_quickhash(pLink));
+    pRequest->WriteToFile(Storage(), aTmpPath, IStorage::TYPE_SAVE);
+    pRequest->Timeout(CTimeout{4000, 0, 500, 5});
+
+    {
+        std::lock_guard<std::mutex> Lock(m_CacheLock);
+        auto It = m_Cache.find(pLink);
+        char aPath[IO_MAX_PATH_LENGTH];
+        if(It != m_Cache.end() && CachedPath(It->second, aPath, sizeof(aPath)))
         {
-            curl_easy_setopt(pCurl, CURLOPT_URL, pLink);
-            curl_easy_setopt(pCurl, CURLOPT_NOBODY, 1L);
-            curl_easy_setopt(pCurl, CURLOPT_HEADERDATA, this);
-            curl_easy_setopt(pCurl, CURLOPT_HEADERFUNCTION, PreDownload);
-            
-            curl_easy_perform(pCurl);
-
-            curl_easy_cleanup(pCurl);
+            if(!It->second.m_ETag.empty())
+                pRequest->HeaderString("If-None-Match", It->second.m_ETag.c_str());
+            if(!It->second.m_LastModified.empty())
+                pRequest->HeaderString("If-Modified-Since", It->second.m_LastModified.c_str());
         }
-        Server()->CreateNewTheardJob(m_LastRequst); 
-    }).detach();
-}
\ No newline at end of file
+    }
+
+    Server()->CreateNewTheardJob(pRequest);
+}
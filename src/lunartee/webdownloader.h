@@ -1,22 +1,50 @@
 #ifndef LUNARTEE_WEBDOWNLOADER_H
 #define LUNARTEE_WEBDOWNLOADER_H
 
+#include <map>
+#include <mutex>
+#include <string>
+
 typedef void (*WEB_CALLBACK)(const char* pUrl, const char* pPath, const char* pFile);
 
+/*
+    Downloads are kept in the cache dir under their SHA-256, the index
+    remembers the ETag and Last-Modified of the url they came from. A
+    cached url is only revalidated, and is used as it is when the
+    download fails, so the server also starts without network.
+*/
 class CWebDownloader
 {
     class IStorage *m_pStorage;
     class IServer *m_pServer;
+
+    struct SCacheEntry
+    {
+        std::string m_Sha256;
+        std::string m_ETag;
+        std::string m_LastModified;
+        std::string m_FileName;
+    };
+
+    // by url, the requests finish on the job threads
+    std::mutex m_CacheLock;
+    std::map<std::string, SCacheEntry> m_Cache;
+
+    void LoadCache();
+    void SaveCache();
+    bool CachedPath(const SCacheEntry &Entry, char *pPath, int PathSize);
+
 public:
     class IStorage *Storage() { return m_pStorage; }
     class IServer *Server() { return m_pServer; }
-    
-    std::shared_ptr<class CDownloadRequst> m_LastRequst;
 
     CWebDownloader(class IStorage *pStorage, class IServer *pServer);
 
-    static size_t PreDownload(void *pData, size_t Size, size_t Number, void *pUser);
-    void Download(const char* pLink, const char* pPath, WEB_CALLBACK pfnCallback = nullptr);
+    // the callback gets the complete path of the cached file
+    void Download(const char* pLink, WEB_CALLBACK pfnCallback = nullptr);
+
+    // takes a finished download into the cache, false if there is no file to use
+    bool Store(class CHttpRequest *pRequest, int State, char *pPath, int PathSize, char *pFile, int FileSize);
 };
 
-#endif // LUNARTEE_WEBDOWNLOADER_H
\ No newline at end of file
+#endif // LUNARTEE_WEBDOWNLOADER_H
@@ -0,0 +1,633 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/logger.h>
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/message.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <game/version.h>
+
+#include <generated/protocol.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+	loadtest - connects simulated 0.6 clients to a server, plays scripted
+	input and acknowledges the snapshots like a real client would. The
+	snapshots are counted but never unpacked.
+
+	The snapshot arrival times include network jitter, so run the server
+	and the load test on the same box for stable numbers. With -a the
+	first client logs into rcon and reads the tick time the server
+	measures itself from 'profile', the server needs dbg_profile 1 for it.
+*/
+
+static volatile sig_atomic_t s_Stop = 0;
+
+static void HandleSigIntTerm(int Param)
+{
+	s_Stop = 1;
+}
+
+class CSamples
+{
+	std::vector<float> m_vSamples;
+
+public:
+	void Add(float Sample) { m_vSamples.push_back(Sample); }
+	int Num() const { return (int)m_vSamples.size(); }
+
+	float Percentile(int Percent)
+	{
+		if(m_vSamples.empty())
+			return 0.0f;
+		std::sort(m_vSamples.begin(), m_vSamples.end());
+		return m_vSamples[(m_vSamples.size() - 1) * Percent / 100];
+	}
+};
+
+class CSimClient
+{
+	enum
+	{
+		STATE_CONNECTING = 0,
+		STATE_LOADING,
+		STATE_INGAME,
+	};
+
+	NETSOCKET m_Socket;
+	CNetConnection m_Connection;
+	CNetRecvUnpacker m_RecvUnpacker;
+
+	int m_ID;
+	int m_State;
+	bool m_SentInfo;
+
+	int m_AckGameTick;
+	int64_t m_LastSnapTime;
+	int m_LastSnapTick;
+
+	int64_t m_PingSendTime;
+	int64_t m_NextPing;
+	int64_t m_NextInput;
+	int64_t m_NextAction;
+
+	const char *m_pRconPassword;
+	bool m_SentRconAuth;
+	bool m_RconAuthed;
+
+	CNetObj_PlayerInput m_Input;
+
+	void SendMsg(CMsgPacker *pMsg, int Flags)
+	{
+		CPacker Packer;
+		Packer.Reset();
+		if(pMsg->m_MsgID < OFFSET_UUID)
+		{
+			Packer.AddInt((pMsg->m_MsgID << 1) | (pMsg->m_System ? 1 : 0));
+		}
+		else
+		{
+			// like CServer::SendMsg, NETMSG_EX followed by the uuid
+			Packer.AddInt((0 << 1) | (pMsg->m_System ? 1 : 0));
+			g_UuidManager.PackUuid(pMsg->m_MsgID, &Packer);
+		}
+		Packer.AddRaw(pMsg->Data(), pMsg->Size());
+
+		if(m_Connection.QueueChunk((Flags & MSGFLAG_VITAL) ? NET_CHUNKFLAG_VITAL : 0, Packer.Size(), Packer.Data()) == 0 && (Flags & MSGFLAG_FLUSH))
+			m_Connection.Flush();
+	}
+
+	void SendInfo(const char *pPassword)
+	{
+		CMsgPacker Msg(NETMSG_INFO, true);
+		Msg.AddString(GAME_NETVERSION, 128);
+		Msg.AddString(pPassword, 128);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendRcon(const char *pCmd)
+	{
+		CMsgPacker Msg(NETMSG_RCON_CMD, true);
+		Msg.AddString(pCmd, 256);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendStartInfo()
+	{
+		char aName[16];
+		str_format(aName, sizeof(aName), "loadtest%d", m_ID);
+
+		CNetMsg_Cl_StartInfo Info;
+		Info.m_pName = aName;
+		Info.m_pClan = "";
+		Info.m_Country = -1;
+		Info.m_pSkin = "default";
+		Info.m_UseCustomColor = 0;
+		Info.m_ColorBody = 0;
+		Info.m_ColorFeet = 0;
+
+		CMsgPacker Msg(NETMSGTYPE_CL_STARTINFO, false);
+		Info.Pack(&Msg);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendInput()
+	{
+		CMsgPacker Msg(NETMSG_INPUT, true);
+		Msg.AddInt(m_AckGameTick);
+		Msg.AddInt(m_LastSnapTick + 3);
+		Msg.AddInt(sizeof(m_Input));
+
+		const int *pData = (const int *)&m_Input;
+		for(unsigned i = 0; i < sizeof(m_Input) / sizeof(int); i++)
+			Msg.AddInt(pData[i]);
+		SendMsg(&Msg, MSGFLAG_FLUSH);
+	}
+
+	// walks, jumps, hooks and shoots at random, like an aimless player
+	void UpdateScript(int64_t Now)
+	{
+		if(Now < m_NextAction)
+			return;
+		m_NextAction = Now + time_freq() * random_int(200, 1500) / 1000;
+
+		m_Input.m_Direction = random_int(-1, 1);
+		m_Input.m_Jump = random_int(0, 3) == 0;
+		m_Input.m_Hook = random_int(0, 4) == 0;
+		m_Input.m_TargetX = random_int(-300, 300);
+		m_Input.m_TargetY = random_int(-300, 300);
+		m_Input.m_WantedWeapon = random_int(0, 5);
+		// an odd fire count holds the trigger
+		if(random_int(0, 2) == 0)
+			m_Input.m_Fire++;
+	}
+
+	void OnMessage(CNetChunk *pChunk, int64_t Now);
+
+public:
+	CSamples *m_pRtt;
+	// client side time between snapshots per game tick, includes network jitter
+	CSamples *m_pSnapInterval;
+	int64_t m_SnapBytes;
+	int64_t m_NumSnaps;
+	int64_t m_IngameTime;
+	int64_t m_EnterTime;
+	bool m_Dropped;
+
+	// p50, p99 and max of the 'tick' zone of the server profiler
+	float m_aServerTickMs[3];
+	bool m_HasServerTick;
+
+	// pRconPassword is null for all clients but the one that reads the profiler
+	bool Open(int ID, const NETADDR *pAddr, CSamples *pRtt, CSamples *pSnapInterval, const char *pRconPassword)
+	{
+		NETADDR BindAddr;
+		mem_zero(&BindAddr, sizeof(BindAddr));
+		BindAddr.type = NETTYPE_ALL;
+
+		m_Socket = net_udp_create(BindAddr);
+		if(!m_Socket)
+			return false;
+
+		m_ID = ID;
+		m_State = STATE_CONNECTING;
+		m_SentInfo = false;
+		m_AckGameTick = -1;
+		m_LastSnapTime = 0;
+		m_LastSnapTick = -1;
+		m_PingSendTime = 0;
+		m_NextPing = 0;
+		m_NextInput = 0;
+		m_NextAction = 0;
+		mem_zero(&m_Input, sizeof(m_Input));
+		m_pRconPassword = pRconPassword;
+		m_SentRconAuth = false;
+		m_RconAuthed = false;
+
+		m_pRtt = pRtt;
+		m_pSnapInterval = pSnapInterval;
+		m_SnapBytes = 0;
+		m_NumSnaps = 0;
+		m_IngameTime = 0;
+		m_EnterTime = 0;
+		m_Dropped = false;
+		mem_zero(m_aServerTickMs, sizeof(m_aServerTickMs));
+		m_HasServerTick = false;
+
+		m_Connection.Init(m_Socket, false);
+		m_Connection.Connect(pAddr, 1);
+		return true;
+	}
+
+	void Close()
+	{
+		m_Connection.Disconnect("load test done");
+		net_udp_close(m_Socket);
+	}
+
+	bool Ingame() const { return m_State == STATE_INGAME; }
+
+	// asks the server for its tick times, m_HasServerTick is set once they arrive
+	bool RequestServerTick()
+	{
+		if(!m_RconAuthed || m_Dropped)
+			return false;
+		SendRcon("profile");
+		return true;
+	}
+
+	void Update(const char *pPassword);
+};
+
+void CSimClient::OnMessage(CNetChunk *pChunk, int64_t Now)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(pChunk->m_pData, pChunk->m_DataSize);
+	CMsgPacker Packer(NETMSG_EX, true);
+
+	int Msg;
+	bool Sys;
+	CUuid Uuid;
+	int Result = UnpackMessageID(&Msg, &Sys, &Uuid, &Unpacker, &Packer);
+	if(Result == UNPACKMESSAGE_ERROR)
+		return;
+	if(Result == UNPACKMESSAGE_ANSWER)
+		SendMsg(&Packer, MSGFLAG_VITAL);
+
+	if(!Sys)
+	{
+		if(Msg == NETMSGTYPE_SV_READYTOENTER)
+		{
+			CMsgPacker Enter(NETMSG_ENTERGAME, true);
+			SendMsg(&Enter, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+
+			m_State = STATE_INGAME;
+			m_EnterTime = Now;
+		}
+		return;
+	}
+
+	if(Msg == NETMSG_MAP_CHANGE)
+	{
+		// the map itself is never needed, pretend it's already downloaded.
+		// This also happens when the server moves the client to another world
+		if(m_State == STATE_INGAME)
+			m_IngameTime += Now - m_EnterTime;
+		m_State = STATE_LOADING;
+		m_AckGameTick = -1;
+		m_LastSnapTick = -1;
+		m_Input.m_Fire = 0;
+
+		CMsgPacker Ready(NETMSG_READY, true);
+		SendMsg(&Ready, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+	else if(Msg == NETMSG_CON_READY)
+	{
+		SendStartInfo();
+	}
+	else if(Msg == NETMSG_PING_REPLY)
+	{
+		if(m_PingSendTime)
+		{
+			m_pRtt->Add((Now - m_PingSendTime) * 1000.0f / time_freq());
+			m_PingSendTime = 0;
+		}
+	}
+	else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+	{
+		int GameTick = Unpacker.GetInt();
+		Unpacker.GetInt(); // delta tick
+		int NumParts = 1;
+		int Part = 0;
+		if(Msg == NETMSG_SNAP)
+		{
+			NumParts = Unpacker.GetInt();
+			Part = Unpacker.GetInt();
+		}
+		if(Unpacker.Error())
+			return;
+
+		m_SnapBytes += pChunk->m_DataSize;
+		if(Part != NumParts - 1)
+			return;
+
+		m_NumSnaps++;
+		if(m_LastSnapTick >= 0 && GameTick > m_LastSnapTick)
+			m_pSnapInterval->Add((Now - m_LastSnapTime) * 1000.0f / time_freq() / (GameTick - m_LastSnapTick));
+		m_LastSnapTime = Now;
+		m_LastSnapTick = maximum(m_LastSnapTick, GameTick);
+
+		// acknowledging the snapshot makes the server send deltas against it
+		m_AckGameTick = maximum(m_AckGameTick, GameTick);
+	}
+	else if(Msg == NETMSG_RCON_AUTH_STATUS)
+	{
+		int Authed = Unpacker.GetInt();
+		if(Unpacker.Error() || !Authed)
+		{
+			dbg_msg("loadtest", "rcon login failed, the server tick time isn't measured");
+			return;
+		}
+
+		// only the ticks under load are of interest
+		m_RconAuthed = true;
+		SendRcon("profile_reset");
+	}
+	else if(Msg == NETMSG_RCON_LINE)
+	{
+		const char *pLine = Unpacker.GetString();
+		if(Unpacker.Error())
+			return;
+
+		// one line per zone: name, count, p50, p99 and max in ms
+		long long Count;
+		if(str_startswith(pLine, "tick ") && sscanf(pLine + 5, "%lld %f %f %f", &Count, &m_aServerTickMs[0], &m_aServerTickMs[1], &m_aServerTickMs[2]) == 4)
+			m_HasServerTick = true;
+		else if(str_startswith(pLine, "profiler is disabled"))
+			dbg_msg("loadtest", "the server profiler is disabled, set dbg_profile 1 to measure the server tick time");
+	}
+}
+
+void CSimClient::Update(const char *pPassword)
+{
+	if(m_Dropped)
+		return;
+
+	m_Connection.Update();
+	if(m_Connection.State() == NET_CONNSTATE_ERROR || m_Connection.State() == NET_CONNSTATE_OFFLINE)
+	{
+		dbg_msg("loadtest", "client %d dropped: %s", m_ID, m_Connection.ErrorString());
+		if(m_State == STATE_INGAME)
+			m_IngameTime += time_get() - m_EnterTime;
+		m_Dropped = true;
+		return;
+	}
+
+	if(m_Connection.State() == NET_CONNSTATE_ONLINE && !m_SentInfo)
+	{
+		SendInfo(pPassword);
+		m_SentInfo = true;
+	}
+
+	while(true)
+	{
+		CNetChunk Chunk;
+		if(m_RecvUnpacker.FetchChunk(&Chunk))
+		{
+			OnMessage(&Chunk, time_get());
+			continue;
+		}
+
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		if(Bytes <= 0)
+			break;
+
+		bool Sixup = false;
+		if(CNetBase::UnpackPacket(pData, Bytes, &m_RecvUnpacker.m_Data, Sixup) != 0)
+			continue;
+		if(m_RecvUnpacker.m_Data.m_Flags & NET_PACKETFLAG_CONNLESS)
+			continue;
+		if(m_Connection.Feed(&m_RecvUnpacker.m_Data, &Addr))
+			m_RecvUnpacker.Start(&Addr, &m_Connection, 0);
+	}
+
+	int64_t Now = time_get();
+	if(m_State != STATE_INGAME)
+		return;
+
+	if(m_pRconPassword && !m_SentRconAuth)
+	{
+		CMsgPacker Auth(NETMSG_RCON_AUTH, true);
+		Auth.AddString("", 32);
+		Auth.AddString(m_pRconPassword, 128);
+		SendMsg(&Auth, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+		m_SentRconAuth = true;
+	}
+
+	if(Now >= m_NextPing && !m_PingSendTime)
+	{
+		CMsgPacker Ping(NETMSG_PING, true);
+		SendMsg(&Ping, MSGFLAG_FLUSH);
+		m_PingSendTime = Now;
+		m_NextPing = Now + time_freq();
+	}
+	else if(m_PingSendTime && Now - m_PingSendTime > time_freq() * 5)
+	{
+		// lost, unreliable messages aren't resent
+		m_PingSendTime = 0;
+	}
+
+	// inputs go out at the tick rate like a real client
+	if(Now >= m_NextInput)
+	{
+		UpdateScript(Now);
+		SendInput();
+		m_NextInput = Now + time_freq() / SERVER_TICK_SPEED;
+	}
+}
+
+static void PrintUsage(const char *pExe)
+{
+	dbg_msg("loadtest", "usage: %s [-n clients] [-t seconds] [-r ramp ms] [-p password] [-a rcon password] [-o result.json] <host:port>", pExe);
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	log_set_global_logger(log_logger_stdout().release());
+
+	int NumClients = 16;
+	int Seconds = 60;
+	int RampMs = 100;
+	const char *pPassword = "";
+	const char *pRconPassword = nullptr;
+	const char *pOutput = nullptr;
+	const char *pAddress = nullptr;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		if(i + 1 < argc && str_comp(argv[i], "-n") == 0) // ignore_convention
+			NumClients = str_toint(argv[++i]); // ignore_convention
+		else if(i + 1 < argc && str_comp(argv[i], "-t") == 0) // ignore_convention
+			Seconds = str_toint(argv[++i]); // ignore_convention
+		else if(i + 1 < argc && str_comp(argv[i], "-r") == 0) // ignore_convention
+			RampMs = str_toint(argv[++i]); // ignore_convention
+		else if(i + 1 < argc && str_comp(argv[i], "-p") == 0) // ignore_convention
+			pPassword = argv[++i]; // ignore_convention
+		else if(i + 1 < argc && str_comp(argv[i], "-a") == 0) // ignore_convention
+			pRconPassword = argv[++i]; // ignore_convention
+		else if(i + 1 < argc && str_comp(argv[i], "-o") == 0) // ignore_convention
+			pOutput = argv[++i]; // ignore_convention
+		else
+			pAddress = argv[i]; // ignore_convention
+	}
+
+	if(!pAddress || NumClients <= 0 || Seconds <= 0)
+	{
+		PrintUsage(argv[0]); // ignore_convention
+		return -1;
+	}
+
+	NETADDR Addr;
+	if(net_host_lookup(pAddress, &Addr, NETTYPE_ALL) != 0)
+	{
+		dbg_msg("loadtest", "couldn't resolve '%s'", pAddress);
+		return -1;
+	}
+	if(!Addr.port)
+		Addr.port = 8303;
+
+	// CNetConnection reads its timeouts from the config
+	CConfig Config;
+	Config.Reset();
+
+	net_init();
+	CNetBase::Init();
+	secure_random_init();
+
+	signal(SIGINT, HandleSigIntTerm);
+	signal(SIGTERM, HandleSigIntTerm);
+
+	CSamples Rtt, SnapInterval;
+	std::vector<std::unique_ptr<CSimClient>> vpClients;
+
+	int64_t Start = time_get();
+	int64_t End = Start + time_freq() * Seconds;
+	int64_t NextReport = Start + time_freq() * 5;
+
+	while(!s_Stop && time_get() < End)
+	{
+		int64_t Now = time_get();
+
+		// connect the clients one by one, a burst of connects isn't what we measure
+		while((int)vpClients.size() < NumClients && Now - Start >= time_freq() * RampMs / 1000 * (int64_t)vpClients.size())
+		{
+			std::unique_ptr<CSimClient> pClient = std::make_unique<CSimClient>();
+			if(!pClient->Open((int)vpClients.size(), &Addr, &Rtt, &SnapInterval, vpClients.empty() ? pRconPassword : nullptr))
+			{
+				dbg_msg("loadtest", "couldn't open a socket for client %d", (int)vpClients.size());
+				s_Stop = 1;
+				break;
+			}
+			vpClients.push_back(std::move(pClient));
+		}
+
+		for(auto &pClient : vpClients)
+			pClient->Update(pPassword);
+
+		if(Now >= NextReport)
+		{
+			int NumIngame = 0;
+			for(auto &pClient : vpClients)
+				NumIngame += pClient->Ingame();
+			dbg_msg("loadtest", "%ds: %d/%d clients ingame", (int)((Now - Start) / time_freq()), NumIngame, NumClients);
+			NextReport += time_freq() * 5;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// the other clients keep the load up while the tick times are fetched
+	int64_t Now = time_get();
+	if(!vpClients.empty() && vpClients[0]->RequestServerTick())
+	{
+		int64_t Timeout = Now + time_freq() * 2;
+		while(!vpClients[0]->m_HasServerTick && time_get() < Timeout)
+		{
+			for(auto &pClient : vpClients)
+				pClient->Update(pPassword);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		Now = time_get();
+	}
+
+	int64_t TotalBytes = 0;
+	int64_t TotalSnaps = 0;
+	float SumRate = 0.0f, MinRate = -1.0f, MaxRate = 0.0f;
+	int NumRated = 0;
+	int NumDropped = 0;
+	for(auto &pClient : vpClients)
+	{
+		if(pClient->Ingame() && !pClient->m_Dropped)
+			pClient->m_IngameTime += Now - pClient->m_EnterTime;
+
+		NumDropped += pClient->m_Dropped;
+		TotalBytes += pClient->m_SnapBytes;
+		TotalSnaps += pClient->m_NumSnaps;
+		if(pClient->m_IngameTime > 0)
+		{
+			float Rate = pClient->m_SnapBytes / ((float)pClient->m_IngameTime / time_freq());
+			SumRate += Rate;
+			NumRated++;
+			MinRate = MinRate < 0.0f ? Rate : minimum(MinRate, Rate);
+			MaxRate = maximum(MaxRate, Rate);
+		}
+		pClient->Close();
+	}
+	float AvgBytes = vpClients.empty() ? 0.0f : (float)TotalBytes / vpClients.size();
+	// each client's rate over its own time in game, like min and max
+	float AvgRate = NumRated ? SumRate / NumRated : 0.0f;
+	const float *pServerTick = !vpClients.empty() && vpClients[0]->m_HasServerTick ? vpClients[0]->m_aServerTickMs : nullptr;
+
+	dbg_msg("loadtest", "clients=%d dropped=%d duration=%.1fs", (int)vpClients.size(), NumDropped, (float)(Now - Start) / time_freq());
+	dbg_msg("loadtest", "snapshot interval per tick: p50=%.2fms p99=%.2fms max=%.2fms (%d samples)", SnapInterval.Percentile(50), SnapInterval.Percentile(99), SnapInterval.Percentile(100), SnapInterval.Num());
+	dbg_msg("loadtest", "rtt: p50=%.2fms p99=%.2fms max=%.2fms (%d samples)", Rtt.Percentile(50), Rtt.Percentile(99), Rtt.Percentile(100), Rtt.Num());
+	dbg_msg("loadtest", "snapshots: %lld total, %.0f bytes per client, %.0f B/s per client (min %.0f, max %.0f)",
+		(long long)TotalSnaps, AvgBytes, AvgRate, maximum(MinRate, 0.0f), MaxRate);
+	if(pServerTick)
+		dbg_msg("loadtest", "server tick: p50=%.3fms p99=%.3fms max=%.3fms", pServerTick[0], pServerTick[1], pServerTick[2]);
+	else
+		dbg_msg("loadtest", "server tick: not measured, pass -a with the rcon password and set dbg_profile 1 on the server");
+
+	if(pOutput)
+	{
+		IOHANDLE File = io_open(pOutput, IOFLAG_WRITE);
+		if(!File)
+		{
+			dbg_msg("loadtest", "couldn't open '%s'", pOutput);
+			return -1;
+		}
+
+		char aServerTick[128];
+		if(pServerTick)
+			str_format(aServerTick, sizeof(aServerTick), "{\"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}", pServerTick[0], pServerTick[1], pServerTick[2]);
+		else
+			str_copy(aServerTick, "null");
+
+		char aBuf[1024];
+		str_format(aBuf, sizeof(aBuf),
+			"{\n"
+			"\t\"clients\": %d,\n"
+			"\t\"dropped\": %d,\n"
+			"\t\"duration\": %.3f,\n"
+			"\t\"snap_interval_ms\": {\"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n"
+			"\t\"rtt_ms\": {\"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n"
+			"\t\"snap_bytes_per_client\": %.0f,\n"
+			"\t\"snap_rate_per_client\": {\"avg\": %.0f, \"min\": %.0f, \"max\": %.0f},\n"
+			"\t\"server_tick_ms\": %s\n"
+			"}\n",
+			(int)vpClients.size(), NumDropped, (float)(Now - Start) / time_freq(),
+			SnapInterval.Percentile(50), SnapInterval.Percentile(99), SnapInterval.Percentile(100),
+			Rtt.Percentile(50), Rtt.Percentile(99), Rtt.Percentile(100),
+			AvgBytes, AvgRate, maximum(MinRate, 0.0f), MaxRate, aServerTick);
+		io_write(File, aBuf, str_length(aBuf));
+		io_close(File);
+	}
+
+	// a dropped client means the server couldn't hold the load
+	return NumDropped ? 1 : 0;
+}